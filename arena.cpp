@@ -0,0 +1,86 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+
+Arena::~Arena()
+{
+	run_finalizers();
+}
+
+void Arena::run_finalizers()
+{
+	for (auto finalizer = finalizers.rbegin(); finalizer != finalizers.rend(); ++finalizer) {
+		finalizer->destroy(finalizer->object);
+	}
+
+	finalizers.clear();
+}
+
+void Arena::reset()
+{
+	run_finalizers();
+	allocated_bytes = 0;
+
+	if (chunks.empty()) {
+		return;
+	}
+
+	chunks.resize(1);
+	cursor = chunks.front().get();
+	limit = cursor + first_chunk_capacity;
+	next_chunk_size = std::min(first_chunk_size * 2, max_chunk_size);
+}
+
+void Arena::grow(const size_t minimal_size)
+{
+	const size_t chunk_size = std::max(next_chunk_size, minimal_size);
+
+	chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(chunk_size));
+	cursor = chunks.back().get();
+	limit = cursor + chunk_size;
+
+	if (chunks.size() == 1) {
+		first_chunk_capacity = chunk_size;
+	}
+
+	next_chunk_size = std::min(next_chunk_size * 2, max_chunk_size);
+}
+
+auto Arena::allocate(const size_t size, const size_t alignment) -> void*
+{
+	auto address = reinterpret_cast<uintptr_t>(cursor);
+	auto aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+
+	if (cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(limit))
+	{
+		// Fresh chunks are aligned for any fundamental type.
+		grow(size + alignment);
+		address = reinterpret_cast<uintptr_t>(cursor);
+		aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+
+	cursor = reinterpret_cast<std::byte*>(aligned + size);
+	allocated_bytes += size;
+
+	return reinterpret_cast<void*>(aligned);
+}
+
+auto Arena::copy_string(const std::string_view source) -> std::string_view
+{
+	if (source.empty()) {
+		return {};
+	}
+
+	auto* target = static_cast<char*>(allocate(source.size(), alignof(char)));
+	std::memcpy(target, source.data(), source.size());
+
+	return { target, source.size() };
+}
+
+auto Arena::get_allocated_bytes() const -> size_t
+{
+	return allocated_bytes;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// --- Note ---
+// The arena hands out memory by bumping a cursor through large chunks. Nothing is
+// released individually: all chunks are freed at once when the arena is destroyed.
+// Objects with trivial destructors cost nothing at teardown. The rest are recorded
+// and destroyed (in reverse order of creation) right before the chunks are freed.
+
+
+class Arena final
+{
+	static constexpr size_t first_chunk_size = 16 * 1024;
+	static constexpr size_t max_chunk_size = 1024 * 1024;
+
+	struct Finalizer final
+	{
+		void (*destroy)(void*);
+		void* object;
+	};
+
+	std::vector<std::unique_ptr<std::byte[]>> chunks;
+	std::vector<Finalizer> finalizers;
+	std::byte* cursor = nullptr;
+	std::byte* limit = nullptr;
+	size_t next_chunk_size = first_chunk_size;
+	size_t allocated_bytes = 0;
+	size_t first_chunk_capacity = 0;
+
+	void grow(size_t minimal_size);
+
+	void run_finalizers();
+
+public:
+	Arena() = default;
+
+	~Arena();
+
+	Arena(const Arena&) = delete;
+	Arena(Arena&&) = delete;
+
+	auto operator=(const Arena&) -> Arena& = delete;
+	auto operator=(Arena&&) -> Arena& = delete;
+
+
+	/// <summary>
+	///	Returns uninitialized memory, valid until the arena is destroyed.
+	/// </summary>
+	[[nodiscard]]
+	auto allocate(size_t size, size_t alignment) -> void*;
+
+	/// <summary>
+	///	Constructs an object owned by the arena.
+	/// </summary>
+	template<typename T, typename... TArgs>
+	auto make(TArgs&&... args) -> T*
+	{
+		T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			finalizers.push_back(Finalizer{
+				[](void* target) { static_cast<T*>(target)->~T(); },
+				object
+			});
+		}
+
+		return object;
+	}
+
+	/// <summary>
+	///	Copies the elements into the arena.
+	/// </summary>
+	template<typename T>
+	auto copy_array(std::span<const T> source) -> std::span<const T>
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivial elements can be copied into the arena.");
+
+		if (source.empty()) {
+			return {};
+		}
+
+		T* target = static_cast<T*>(allocate(source.size_bytes(), alignof(T)));
+		std::uninitialized_copy(source.begin(), source.end(), target);
+
+		return { target, source.size() };
+	}
+
+	/// <summary>
+	///	Creates an array of default-constructed elements owned by the arena.
+	/// </summary>
+	template<typename T>
+	auto make_array(const size_t count) -> std::span<T>
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arrays in the arena are never destroyed.");
+
+		if (count == 0) {
+			return {};
+		}
+
+		T* target = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		std::uninitialized_value_construct_n(target, count);
+
+		return { target, count };
+	}
+
+	/// <summary>
+	///	Copies the characters into the arena.
+	/// </summary>
+	auto copy_string(std::string_view source) -> std::string_view;
+
+	/// <summary>
+	///	Destroys everything the arena holds. The first chunk is kept for reuse, the others are freed.
+	/// </summary>
+	void reset();
+
+
+	[[nodiscard]]
+	auto get_allocated_bytes() const -> size_t;
+};
@@ -1,11 +1,15 @@
 #include "ast.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
 #include <valarray>
 
+#include "memo.h"
+#include "profiler.h"
+
 
 [[noreturn]]
 void terminate_illegal_program(const std::string& reasoning) {
@@ -13,9 +17,9 @@ void terminate_illegal_program(const std::string& reasoning) {
 	throw std::runtime_error("Illegal program can not be executed.");
 }
 
-void append_str_buf(std::stringbuf& buf, const std::string& str)
+void append_str_buf(std::stringbuf& buf, const std::string_view str)
 {
-	buf.sputn(str.c_str(), static_cast<std::streamsize>(str.length()));
+	buf.sputn(str.data(), static_cast<std::streamsize>(str.length()));
 }
 
 template<typename T>
@@ -36,25 +40,37 @@ auto get_value_casted(const Value* input, const char* error_msg) -> T
 }
 
 
-std::string str_to_cpp(const char* copy)
+Value::Value(const Logic value) : type(Type::Logic)
 {
-	std::string result{ copy };
-	delete[] (copy);
-	return result;
+	payload.logic = value;
+}
+
+Value::Value(const Number value) : type(Type::Number)
+{
+	payload.number = value;
+}
+
+Value::Value(Text text) : type(Type::Text)
+{
+	payload.text = new SharedText{ 1, std::move(text) };
 }
 
-Value::Value(Logic value) : value(value) {}
-Value::Value(Number value) : value(value) {}
-Value::Value(Text text) : value(text) {}
+void Value::detach_text()
+{
+	if (payload.text->references > 1) {
+		--payload.text->references;
+		payload.text = new SharedText{ 1, payload.text->text };
+	}
+}
 
 
-Variable::Variable(std::string name, Value init_value)
-	: name(std::move(name))
+Variable::Variable(const Symbol name, Value init_value)
+	: name(name)
 	, value(std::move(init_value))
 {
 }
 
-auto Variable::get_name() const -> const std::string&
+auto Variable::get_name() const -> Symbol
 {
 	return this->name;
 }
@@ -71,40 +87,120 @@ auto Variable::get_value() -> Value&
 
 
 
-Function::Function(std::string name, StatementNode* body, Signature signature)
-	: name(std::move(name))
+Function::Function(const Symbol name, StatementNode* body, const Signature signature, const FunctionTraits& traits)
+	: name(name)
 	, body(body)
-	, signature(std::move(signature))
+	, signature(signature)
+	, traits(&traits)
 {
 }
 
-auto Function::call(ExecutionScopedState& context, const std::vector<std::string>& args) const -> std::optional<Value>
+void Function::check_call(ExecutionBudget& budget, const size_t argument_count) const
 {
-	bool termination_token = false;
+	budget.charge();
+
+	if (argument_count != signature.size()) {
+		terminate_illegal_program("Function " + std::string(symbols().get_name(name)) + " expects " + std::to_string(signature.size()) + " arguments.");
+	}
+}
+
+auto Function::call(ExecutionScopedState& context, const ArgsListNode& args_node) const -> std::optional<Value>
+{
+	ExecutionBudget& budget = context.get_budget();
+
+	check_call(budget, args_node.get_list().size());
+
+	// A pure call with the same inputs as an earlier one has the same result.
+	MemoTable* memo_table = traits->is_memoized ? context.get_memo_table() : nullptr;
+	std::vector<Value> memo_inputs;
+
+	if (memo_table != nullptr)
+	{
+		std::vector<Value>& probe = memo_table->get_probe();
+
+		if (!gather_inputs(context, args_node, probe)) {
+			memo_table = nullptr;
+		}
+		else if (const std::optional<Value>* memoized = memo_table->find(body, probe)) {
+			return *memoized;
+		}
+		else {
+			memo_inputs = probe;
+		}
+	}
+
+	budget.enter_call();
+
 	std::optional<Value> result;
-	ExecutionScopedState call_context{ &context, &termination_token, &result };
+	TailCall tail_call;
 
-	// REBIND ARGS
-	for (size_t i = 0; i < args.size(); ++i) 
 	{
-		const auto& arg = args.at(i);
-		const Value* value = context.try_get_var_value(arg);
+		ExecutionScopedState call_context{ &context, &result, &tail_call };
 
-		if (value == nullptr) {
-			terminate_illegal_program("Function argument " + arg + " does not exist.");
+		// REBIND ARGS
+		for (size_t i = 0; i < signature.size(); ++i) 
+		{
+			Variable variable{ signature[i], args_node.get_argument(context, i) };
+
+			call_context.declare_variable(std::move(variable));
+		}
+
+		(void)body->execute(call_context);
+	}
+
+	std::vector<Value> arguments;
+
+	while (tail_call.function.has_value())
+	{
+		const Function callee = *tail_call.function;
+		tail_call.function.reset();
+		arguments.swap(tail_call.arguments);
+
+		ExecutionScopedState call_context{ &context, &result, &tail_call };
+
+		for (size_t i = 0; i < arguments.size(); ++i) {
+			call_context.declare_variable(Variable{ callee.signature[i], std::move(arguments[i]) });
 		}
 
-		Variable variable{ signature.at(i), *value };
+		arguments.clear();
+		(void)callee.body->execute(call_context);
 
-		call_context.declare_variable(std::move(variable));
+		// The call was the returned expression.
+		if (!result.has_value() && !tail_call.function.has_value()) {
+			terminate_illegal_program("Function does not return anything.");
+		}
 	}
 
-	body->execute(call_context);
+	budget.leave_call();
+
+	if (memo_table != nullptr) {
+		memo_table->store(body, std::move(memo_inputs), result);
+	}
 
 	return result;
 }
 
-auto Function::get_name() const -> const std::string&
+auto Function::gather_inputs(const ExecutionScopedState& context, const ArgsListNode& args_node, std::vector<Value>& probe) const -> bool
+{
+	for (size_t i = 0; i < signature.size(); ++i) {
+		probe.push_back(args_node.get_argument(context, i));
+	}
+
+	for (const Symbol name : traits->free_reads)
+	{
+		const Value* value = context.try_get_var_value(name);
+
+		if (value == nullptr) {
+			return false;
+		}
+
+		probe.push_back(*value);
+	}
+
+	return true;
+}
+
+auto Function::get_name() const -> Symbol
 {
 	return this->name;
 }
@@ -124,7 +220,7 @@ namespace ValueVisitors
 			*target = "Number: " + std::to_string(number);
 		}
 
-		void operator()(const Value::Text text) const {
+		void operator()(const Value::Text& text) const {
 			*target = "Text: " + text;
 		}
 	};
@@ -143,9 +239,9 @@ namespace ValueVisitors
 			auto calc = [arithmetic_operation, l, r]() -> Value::Number
 			{
 				switch (arithmetic_operation) {
-					case ArithmeticOperation::Addition:			return l + r;
-					case ArithmeticOperation::Substraction:		return l - r;
-					case ArithmeticOperation::Multiplication:	return l * r;
+					case ArithmeticOperation::Addition:			return NumberArithmetic::add(l, r);
+					case ArithmeticOperation::Substraction:		return NumberArithmetic::subtract(l, r);
+					case ArithmeticOperation::Multiplication:	return NumberArithmetic::multiply(l, r);
 					case ArithmeticOperation::Division:			return l / r;
 					case ArithmeticOperation::Modulo:			return l % r;
 				}
@@ -161,7 +257,7 @@ namespace ValueVisitors
 			const Value::Logic l = get_value_casted<Value::Logic>(left_value, "Left operand must a boolean to execute arithmetic operation.");
 			const Value::Logic r = get_value_casted<Value::Logic>(right_value, "Right operand must a boolean to execute arithmetic operation.");
 
-			auto calc = [logic_operation, l, r]() -> Value::Number
+			auto calc = [logic_operation, l, r]() -> Value::Logic
 			{
 				switch (logic_operation) {
 					case LogicOperation::And:	return l && r;
@@ -244,20 +340,87 @@ namespace ValueVisitors
 		}
 	};
 
-	struct Reassignment final
+}
+
+
+namespace TypedEvaluation
+{
+	auto apply(const TypedOperation operation, const Value::Number l, const Value::Number r) -> Value
 	{
-		Value* target;
+		switch (operation) {
+			case TypedOperation::NumberAddition:		return Value(NumberArithmetic::add(l, r));
+			case TypedOperation::NumberSubstraction:	return Value(NumberArithmetic::subtract(l, r));
+			case TypedOperation::NumberMultiplication:	return Value(NumberArithmetic::multiply(l, r));
+			case TypedOperation::NumberDivision:		return Value(l / r);
+			case TypedOperation::NumberModulo:			return Value(l % r);
+			case TypedOperation::NumberEquality:		return Value(l == r);
+			case TypedOperation::NumberInequality:		return Value(l != r);
+			case TypedOperation::NumberLess:			return Value(l < r);
+			case TypedOperation::NumberLessOrEqual:		return Value(l <= r);
+			case TypedOperation::NumberMore:			return Value(l > r);
+			case TypedOperation::NumberMoreOrEqual:		return Value(l >= r);
+			default:
+				terminate_illegal_program("Unknown typed operation.");
+		}
+	}
 
-		void operator()(const Value::Logic boolean) const {
-			*target = Value(boolean);
+	auto apply(const TypedOperation operation, const Value::Logic l, const Value::Logic r) -> Value
+	{
+		switch (operation) {
+			case TypedOperation::LogicAnd:			return Value(l && r);
+			case TypedOperation::LogicOr:			return Value(l || r);
+			case TypedOperation::LogicXor:			return Value(l != r);
+			case TypedOperation::LogicEquality:		return Value(l == r);
+			case TypedOperation::LogicInequality:	return Value(l != r);
+			default:
+				terminate_illegal_program("Unknown typed operation.");
 		}
+	}
 
-		void operator()(const Value::Number number) const {
-			*target = Value(number);
+	auto apply(const UnaryOperation operation, const Value& operand) -> Value
+	{
+		return operation == UnaryOperation::Not
+			? Value(!operand.get_unchecked<Value::Logic>())
+			: Value(NumberArithmetic::negate(operand.get_unchecked<Value::Number>()));
+	}
+
+	struct TypedOperationSelector final
+	{
+		Value::Type operand_type;
+
+		auto operator()(const ArithmeticOperation operation) const -> std::optional<TypedOperation>
+		{
+			if (operand_type != Value::Type::Number) {
+				return std::nullopt;
+			}
+
+			return static_cast<TypedOperation>(static_cast<int>(TypedOperation::NumberAddition) + static_cast<int>(operation));
 		}
 
-		void operator()(const Value::Text text) const {
-			*target = Value(text);
+		auto operator()(const LogicOperation operation) const -> std::optional<TypedOperation>
+		{
+			if (operand_type != Value::Type::Logic) {
+				return std::nullopt;
+			}
+
+			return static_cast<TypedOperation>(static_cast<int>(TypedOperation::LogicAnd) + static_cast<int>(operation));
+		}
+
+		auto operator()(const ComparisonOperation operation) const -> std::optional<TypedOperation>
+		{
+			if (operand_type == Value::Type::Number) {
+				return static_cast<TypedOperation>(static_cast<int>(TypedOperation::NumberEquality) + static_cast<int>(operation));
+			}
+
+			if (operand_type != Value::Type::Logic) {
+				return std::nullopt;
+			}
+
+			switch (operation) {
+				case ComparisonOperation::Equality:		return TypedOperation::LogicEquality;
+				case ComparisonOperation::Inequality:	return TypedOperation::LogicInequality;
+				default:								return std::nullopt;
+			}
 		}
 	};
 }
@@ -265,126 +428,209 @@ namespace ValueVisitors
 
 void Value::reassign(const Value& src)
 {
-	if (src.value.index() != this->value.index())
+	if (src.type != this->type)
 	{
 		terminate_illegal_program("Variable type can not be changed.");
 	}
 
-	ValueVisitors::Reassignment reassignment;
-	reassignment.target = this;
+	*this = src;
+}
 
-	std::visit(reassignment, src.value);
+auto Value::to_string() const -> std::string
+{
+	std::string str;
+	handle_by_visitor(ValueVisitors::ValuePrinter{ &str });
+	return str;
 }
 
 
 
-// Creates a predicate to be used to search variable by its name.
-auto get_var_name_predicate(std::string_view name)
+ValueStack::ValueStack()
+	: identity(last_identity.fetch_add(1, std::memory_order_relaxed) + 1)
 {
-	return [name](const Variable& var) -> bool {
-		return var.get_name() == name;
-	};
+	variables.reserve(initial_capacity);
+	functions.reserve(initial_capacity);
+}
+
+void ValueStack::bump_functions_epoch()
+{
+	++functions_epoch;
+}
+
+void ValueStack::bump_variables_epoch()
+{
+	++variables_epoch;
 }
 
 
-ExecutionScopedState::ExecutionScopedState(bool* termination_token, std::optional<Value>* result)
-	: result(result)
-	, termination_token(termination_token)
+ExecutionScopedState::ExecutionScopedState(ValueStack& stack, ExecutionBudget& budget, MemoTable* memo_table, Profiler* profiler, std::optional<Value>* result)
+	: stack(&stack)
+	, budget(&budget)
+	, memo_table(memo_table)
+	, profiler(profiler)
+	, variables_base(stack.variables.size())
+	, functions_base(stack.functions.size())
+	, result(result)
 {
 
 }
 
-ExecutionScopedState::ExecutionScopedState(ExecutionScopedState* parent_state, bool* termination_token, std::optional<Value>* result)
+ExecutionScopedState::ExecutionScopedState(ExecutionScopedState* parent_state, std::optional<Value>* result, TailCall* tail_call)
 	: parent_state(parent_state)
+	, stack(parent_state->stack)
+	, budget(parent_state->budget)
+	, memo_table(parent_state->memo_table)
+	, profiler(parent_state->profiler)
+	, variables_base(parent_state->stack->variables.size())
+	, functions_base(parent_state->stack->functions.size())
 	, result(result)
-	, termination_token(termination_token)
+	, tail_call(tail_call)
 	, level(parent_state->level + 1)
 {
 }
 
-auto ExecutionScopedState::try_get_var_value(const std::string_view name) -> Value*
+ExecutionScopedState::~ExecutionScopedState()
 {
-	auto result = std::find_if(
-		variables.begin(),
-		variables.end(),
-		get_var_name_predicate(name)
-	);
+	if (stack->variables.size() != variables_base) {
+		stack->variables.erase(stack->variables.begin() + static_cast<ptrdiff_t>(variables_base), stack->variables.end());
+		stack->bump_variables_epoch();
+	}
 
-	const bool found = result != variables.end();
+	if (stack->functions.size() != functions_base) {
+		stack->functions.erase(stack->functions.begin() + static_cast<ptrdiff_t>(functions_base), stack->functions.end());
+		stack->bump_functions_epoch();
+	}
+}
 
-	if (!found && parent_state) {
-		if (Value* parent_value = parent_state->try_get_var_value(name)) 
-		{
-			return parent_value;
+auto ExecutionScopedState::try_get_var_value(const Symbol name) -> Value*
+{
+	const auto& self = *this;
+	return const_cast<Value*>(self.try_get_var_value(name));
+}
+
+auto ExecutionScopedState::try_get_var_value(const Symbol name) const -> const Value*
+{
+	auto& variables = stack->variables;
+
+	for (auto variable = variables.rbegin(); variable != variables.rend(); ++variable)
+	{
+		if (variable->get_name() == name) {
+			return &variable->get_value();
 		}
 	}
 
-	return found ? (&result->get_value()) : nullptr;
+	return nullptr;
 }
 
-auto ExecutionScopedState::try_get_var_value(const std::string_view name) const -> const Value*
+auto ExecutionScopedState::try_get_var_value(const Symbol name, VariableCache& cache) -> Value*
 {
-	auto result = std::find_if(
-		variables.begin(),
-		variables.end(),
-		get_var_name_predicate(name)
-	);
+	const auto& self = *this;
+	return const_cast<Value*>(self.try_get_var_value(name, cache));
+}
 
-	const bool found = result != variables.end();
+auto ExecutionScopedState::try_get_var_value(const Symbol name, VariableCache& cache) const -> const Value*
+{
+	if (cache.stack == stack->identity && cache.epoch == stack->variables_epoch) {
+		return &stack->variables[cache.index].get_value();
+	}
 
-	if (!found && parent_state) {
-		if (const Value* parent_value = parent_state->try_get_var_value(name))
-		{
-			return parent_value;
+	auto& variables = stack->variables;
+
+	for (auto variable = variables.rbegin(); variable != variables.rend(); ++variable)
+	{
+		if (variable->get_name() == name) {
+			cache.stack = stack->identity;
+			cache.epoch = stack->variables_epoch;
+			cache.index = static_cast<size_t>(variables.rend() - variable) - 1;
+			return &variable->get_value();
 		}
 	}
 
-	return found ? (&result->get_value()) : nullptr;
+	return nullptr;
 }
 
-auto ExecutionScopedState::try_get_function(std::string_view name) const -> const Function*
+auto ExecutionScopedState::try_get_function(const Symbol name) const -> const Function*
 {
-	auto result = std::find_if(
-		functions.begin(),
-		functions.end(),
-		[name](const Function& func) -> bool
-		{
-			return name == func.get_name();
+	const auto& functions = stack->functions;
+
+	for (auto function = functions.rbegin(); function != functions.rend(); ++function)
+	{
+		if (function->get_name() == name) {
+			return &(*function);
 		}
-	);
+	}
 
-	const bool found = result != functions.end();
+	return nullptr;
+}
 
-	if (!found && parent_state) {
-		if (const Function* parent_function = parent_state->try_get_function(name)) {
-			return parent_function;
-		}
+auto ExecutionScopedState::try_get_function(const Symbol name, FunctionCache& cache) const -> const Function*
+{
+	if (cache.stack == stack->identity && cache.epoch == stack->functions_epoch) {
+		return &stack->functions[cache.index];
+	}
+
+	const Function* function = try_get_function(name);
+
+	if (function != nullptr) {
+		cache.stack = stack->identity;
+		cache.epoch = stack->functions_epoch;
+		cache.index = static_cast<size_t>(function - stack->functions.data());
+	}
+
+	return function;
+}
+
+auto ExecutionScopedState::get_var_value(const VariableSlot slot) -> Value&
+{
+	const auto& self = *this;
+	return const_cast<Value&>(self.get_var_value(slot));
+}
+
+auto ExecutionScopedState::get_var_value(const VariableSlot slot) const -> const Value&
+{
+	const ExecutionScopedState* state = this;
+
+	for (int32_t i = 0; i < slot.depth; ++i) {
+		state = state->parent_state;
 	}
 
-	return found ? &(*result) : nullptr;
+	return stack->variables[state->variables_base + slot.index].get_value();
+}
+
+void ExecutionScopedState::push_variable(Variable&& variable)
+{
+	stack->variables.emplace_back(std::move(variable));
+	stack->bump_variables_epoch();
 }
 
 void ExecutionScopedState::declare_variable(Variable&& variable)
 {
+	auto& variables = stack->variables;
+
 	const auto result = std::find_if(
-		variables.begin(),
+		variables.begin() + static_cast<ptrdiff_t>(variables_base),
 		variables.end(),
-		get_var_name_predicate(variable.get_name())
+		[name = variable.get_name()](const Variable& var) -> bool
+		{
+			return var.get_name() == name;
+		}
 	);
 
 	if (result != variables.end()) {
 		terminate_illegal_program("Value with given name is already declared.");
 	}
 
-	this->variables.emplace_back(std::move(variable));
+	variables.emplace_back(std::move(variable));
+	stack->bump_variables_epoch();
 }
 
 void ExecutionScopedState::declare_function(Function&& function)
 {
-	auto name = function.get_name();
+	const Symbol name = function.get_name();
+	auto& functions = stack->functions;
 
 	const auto result = std::find_if(
-		functions.begin(),
+		functions.begin() + static_cast<ptrdiff_t>(functions_base),
 		functions.end(),
 		[name](const Function& func) -> bool
 		{
@@ -396,7 +642,8 @@ void ExecutionScopedState::declare_function(Function&& function)
 		terminate_illegal_program("Function with given name is already declared.");
 	}
 
-	this->functions.emplace_back(std::move(function));
+	functions.emplace_back(std::move(function));
+	stack->bump_functions_epoch();
 }
 
 void ExecutionScopedState::set_result(Value&& value)
@@ -418,28 +665,36 @@ auto ExecutionScopedState::get_result_target() -> std::optional<Value>*
 	return this->result;
 }
 
-void ExecutionScopedState::mark_termination()
+auto ExecutionScopedState::get_tail_call_target() const -> TailCall*
+{
+	return tail_call;
+}
+
+auto ExecutionScopedState::get_budget() const -> ExecutionBudget&
 {
-	*termination_token = true;
+	return *budget;
 }
 
-auto ExecutionScopedState::is_terminated() const -> bool
+auto ExecutionScopedState::get_memo_table() const -> MemoTable*
 {
-	return *termination_token;
+	return memo_table;
 }
 
-auto ExecutionScopedState::get_termination_token() const -> bool*
+auto ExecutionScopedState::get_profiler() const -> Profiler*
 {
-	return termination_token;
+	return profiler;
 }
 
 void ExecutionScopedState::print_summary()
 {
-	for (const auto& variable : this->variables) {
+	const auto& variables = stack->variables;
+
+	for (size_t i = variables_base; i < variables.size(); ++i) {
+		const Variable& variable = variables[i];
 		std::string str;
 		ValueVisitors::ValuePrinter printer{ &str };
 		variable.get_value().handle_by_visitor(printer);
-		std::cout << variable.get_name() << " = " << str << "\n";
+		std::cout << symbols().get_name(variable.get_name()) << " = " << str << "\n";
 	}
 }
 
@@ -451,20 +706,19 @@ AstRoot::AstRoot(StatementNode* head_statement)
 
 
 
-ArgsListNode::ArgsListNode(std::string name)
-	: name(name)
+ArgsListNode::ArgsListNode(Arena& arena, const std::span<const Symbol> names)
+	: slots(arena.make_array<VariableSlot>(names.size()))
 {
-}
+	// Parameters and arguments have always been bound starting with the last one written.
+	const std::span<Symbol> reversed = arena.make_array<Symbol>(names.size());
+	std::reverse_copy(names.begin(), names.end(), reversed.begin());
 
-ArgsListNode::ArgsListNode(std::string name, ArgsListNode* next)
-	: name(name)
-	, next(std::unique_ptr<ArgsListNode>(next))
-{
+	this->list = reversed;
 }
 
 
 BraceExpressionNode::BraceExpressionNode(ExpressionNode* braced_expression)
-	: braced_expression(std::unique_ptr<ExpressionNode>(braced_expression))
+	: braced_expression(braced_expression)
 {
 }
 
@@ -479,7 +733,7 @@ UnaryOperationNode::UnaryOperationNode(
 	ExpressionNode* child)
 	: ExpressionNode()
 	, operator_(op)
-	, child(std::unique_ptr<ExpressionNode>(child))
+	, child(child)
 {
 }
 
@@ -489,43 +743,62 @@ BinaryOperationNode::BinaryOperationNode(
 	ExpressionNode* right)
 	: ExpressionNode()
 	, operation_(op)
-	, left_child(std::unique_ptr<ExpressionNode>(left))
-	, right_child(std::unique_ptr<ExpressionNode>(right))
+	, left_child(left)
+	, right_child(right)
+	, right_contains_call(right->contains_call())
 {
 }
 
-VariableReferenceNode::VariableReferenceNode(std::string&& name)
+VariableReferenceNode::VariableReferenceNode(const Symbol name)
 	: ExpressionNode()
-	, name(std::move(name))
+	, name(name)
+{
+}
+
+TypedBinaryOperationNode::TypedBinaryOperationNode(
+	const TypedOperation operation,
+	ExpressionNode* left,
+	ExpressionNode* right)
+	: ExpressionNode()
+	, operation(operation)
+	, left_child(left)
+	, right_child(right)
+{
+}
+
+TypedUnaryOperationNode::TypedUnaryOperationNode(
+	const UnaryOperation operation,
+	ExpressionNode* child)
+	: ExpressionNode()
+	, operation(operation)
+	, child(child)
 {
 }
 
 ResultNode::ResultNode(ExpressionNode* result_expression)
-	: result_expression(std::unique_ptr<ExpressionNode>(result_expression))
+	: result_expression(result_expression)
 {
 }
 
 
 VariableAssignmentNode::VariableAssignmentNode(
-	std::string variable_name,
+	const Symbol variable_name,
 	ExpressionNode* expression,
 	const bool reassignment)
-	: variable_name(std::move(variable_name))
-	, expression(std::unique_ptr<ExpressionNode>(expression))
+	: variable_name(variable_name)
+	, expression(expression)
 	, is_reassignment(reassignment)
+	, expression_contains_call(expression->contains_call())
 {
 }
 
-MultiStatementsNode::MultiStatementsNode(
-	StatementNode* left_statement, 
-	StatementNode* right_statement)
-	: left_statement(std::unique_ptr<StatementNode>(left_statement))
-	, right_statement(std::unique_ptr<StatementNode>(right_statement))
+BlockNode::BlockNode(Arena& arena, const std::span<StatementNode* const> statements)
+	: statements(arena.copy_array(statements))
 {
 }
 
 BodyNode::BodyNode(StatementNode* body_statement)
-	: body_statement(std::unique_ptr<StatementNode>(body_statement))
+	: body_statement(body_statement)
 {
 }
 
@@ -533,51 +806,97 @@ ConditionalStatementNode::ConditionalStatementNode(
 	ExpressionNode* condition,
 	StatementNode* statement,
 	const bool repeating)
-	: condition(std::unique_ptr<ExpressionNode>(condition))
-	, statement(std::unique_ptr<StatementNode>(statement))
+	: condition(condition)
+	, statement(statement)
 	, repeating(repeating)
 {
 }
 
 
 FunctionDeclarationNode::FunctionDeclarationNode(
-	std::string name, 
+	const Symbol name,
 	StatementNode* body_node,
 	ArgsListNode* args)
-	: name(std::move(name))
-	, body(std::unique_ptr<StatementNode>(body_node))
-	, args(std::unique_ptr<ArgsListNode>(args))
+	: name(name)
+	, body(body_node)
+	, args(args)
 {
 }
 
 FunctionCallNode::FunctionCallNode(
-	std::string name,
+	const Symbol name,
 	ArgsListNode* args)
-	: name(std::move(name))
-	, args(std::unique_ptr<ArgsListNode>(args))
+	: name(name)
+	, args(args)
 {
 }
 
-PrintNode::PrintNode(std::string name) : name(std::move(name))
+PrintNode::PrintNode(const Symbol name) : name(name)
 {
 }
 
+IncrementNode::IncrementNode(const Symbol variable_name, const Value::Number amount)
+	: variable_name(variable_name)
+	, amount(amount)
+{
+}
 
-auto BraceExpressionNode::evaluate(const ExecutionScopedState& execution_scoped_state) -> Value
+ComparisonLoopNode::ComparisonLoopNode(
+	ConditionalStatementNode* loop,
+	const ComparisonOperation operation,
+	DirectOperand left,
+	DirectOperand right)
+	: loop(loop)
+	, operation(operation)
+	, left(std::move(left))
+	, right(std::move(right))
 {
-	return braced_expression->evaluate(execution_scoped_state);
 }
 
-auto LiteralNode::evaluate(const ExecutionScopedState& execution_scoped_state) -> Value
+
+auto ExpressionNode::evaluate(const ExecutionScopedState& execution_scoped_state) -> Value
+{
+	Value scratch;
+	const Value& result = this->borrow(execution_scoped_state, scratch);
+
+	if (&result == &scratch) {
+		return scratch;
+	}
+
+	return result;
+}
+
+auto BraceExpressionNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
+{
+	return braced_expression->borrow(execution_scoped_state, scratch);
+}
+
+auto LiteralNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
 {
 	return this->value;
 }
 
-auto UnaryOperationNode::evaluate(const ExecutionScopedState& execution_scoped_state) -> Value
+auto UnaryOperationNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
 {
-	const Value child_value = this->child->evaluate(execution_scoped_state);
+	const Value& child_value = this->child->borrow(execution_scoped_state, scratch);
+	const bool is_operand_expected = child_value.get_type() == (operator_ == UnaryOperation::Not ? Value::Type::Logic : Value::Type::Number);
+
+	if (this->is_quickened)
+	{
+		if (is_operand_expected) {
+			scratch = TypedEvaluation::apply(operator_, child_value);
+			return scratch;
+		}
 
-	Value result;
+		this->is_quickened = false;
+	}
+	else if (is_operand_expected && this->quickenings < max_quickenings)
+	{
+		this->is_quickened = true;
+		++this->quickenings;
+	}
+
+	Value& result = scratch;
 	switch (operator_) {
 		case UnaryOperation::Not:
 		{
@@ -592,7 +911,7 @@ auto UnaryOperationNode::evaluate(const ExecutionScopedState& execution_scoped_s
 			const Value::Number numberValue = get_value_casted<Value::Number>(
 				&child_value,
 				"Negation with a minus can be done only on numbers!");
-			result = Value(-1 * numberValue);
+			result = Value(NumberArithmetic::negate(numberValue));
 			break;
 		}
 		default:
@@ -602,41 +921,207 @@ auto UnaryOperationNode::evaluate(const ExecutionScopedState& execution_scoped_s
 	return result;
 }
 
-auto BinaryOperationNode::evaluate(const ExecutionScopedState& execution_scoped_state) -> Value
+auto BinaryOperationNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
 {
 	ValueVisitors::BinaryOperation visitor;
 
-	Value result;
-	const Value left_value = this->left_child->evaluate(execution_scoped_state);
-	const Value right_value = this->right_child->evaluate(execution_scoped_state);
+	Value left_scratch;
+	Value right_scratch;
+	const Value* left_value = &this->left_child->borrow(execution_scoped_state, left_scratch);
+
+	// The call may reassign the borrowed variable, while the operation must see its current value.
+	if (this->right_contains_call && left_value != &left_scratch) {
+		left_scratch = *left_value;
+		left_value = &left_scratch;
+	}
 
-	visitor.result = &result;
-	visitor.left_value = &left_value;
+	const Value& right_value = this->right_child->borrow(execution_scoped_state, right_scratch);
+
+	if (this->quickened.has_value())
+	{
+		const Value::Type operand_type = get_operand_type(*this->quickened);
+
+		if (left_value->get_type() == operand_type && right_value.get_type() == operand_type)
+		{
+			scratch = operand_type == Value::Type::Number
+				? TypedEvaluation::apply(*this->quickened, left_value->get_unchecked<Value::Number>(), right_value.get_unchecked<Value::Number>())
+				: TypedEvaluation::apply(*this->quickened, left_value->get_unchecked<Value::Logic>(), right_value.get_unchecked<Value::Logic>());
+
+			return scratch;
+		}
+
+		this->quickened.reset();
+	}
+	else if (left_value->get_type() == right_value.get_type() && this->quickenings < max_quickenings)
+	{
+		this->quickened = this->get_typed_operation(left_value->get_type());
+		++this->quickenings;
+	}
+
+	visitor.result = &scratch;
+	visitor.left_value = left_value;
 	visitor.right_value = &right_value;
 
 	std::visit(visitor, this->operation_);
 
-	return result;
+	return scratch;
+}
+
+auto BinaryOperationNode::get_typed_operation(const Value::Type operand_type) const -> std::optional<TypedOperation>
+{
+	return std::visit(TypedEvaluation::TypedOperationSelector{ operand_type }, this->operation_);
 }
 
-auto VariableReferenceNode::evaluate(const ExecutionScopedState& execution_scoped_state) -> Value
+auto VariableReferenceNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
 {
-	const Value* value = execution_scoped_state.try_get_var_value(this->name);
+	if (!this->slot.is_dynamic()) {
+		return execution_scoped_state.get_var_value(this->slot);
+	}
+
+	const Value* value = execution_scoped_state.try_get_var_value(this->name, this->cache);
 
 	if (value == nullptr) {
 		terminate_illegal_program("Value is null and can not be evaluated.");
 	}
 
-	Value result = *value;
-	return result;
+	return *value;
+}
+
+auto TypedBinaryOperationNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
+{
+	// The left operand is copied out before the right one runs, so a call there can not change it.
+	if (get_operand_type(this->operation) == Value::Type::Number)
+	{
+		const Value::Number l = this->left_child->borrow(execution_scoped_state, scratch).get_unchecked<Value::Number>();
+		const Value::Number r = this->right_child->borrow(execution_scoped_state, scratch).get_unchecked<Value::Number>();
+		scratch = TypedEvaluation::apply(this->operation, l, r);
+	}
+	else
+	{
+		const Value::Logic l = this->left_child->borrow(execution_scoped_state, scratch).get_unchecked<Value::Logic>();
+		const Value::Logic r = this->right_child->borrow(execution_scoped_state, scratch).get_unchecked<Value::Logic>();
+		scratch = TypedEvaluation::apply(this->operation, l, r);
+	}
+
+	return scratch;
+}
+
+auto TypedUnaryOperationNode::borrow(const ExecutionScopedState& execution_scoped_state, Value& scratch) -> const Value&
+{
+	const Value& child_value = this->child->borrow(execution_scoped_state, scratch);
+	scratch = TypedEvaluation::apply(this->operation, child_value);
+
+	return scratch;
+}
+
+
+auto BraceExpressionNode::contains_call() const -> bool
+{
+	return braced_expression->contains_call();
+}
+
+auto LiteralNode::contains_call() const -> bool
+{
+	return false;
+}
+
+auto UnaryOperationNode::contains_call() const -> bool
+{
+	return child->contains_call();
+}
+
+auto BinaryOperationNode::contains_call() const -> bool
+{
+	return left_child->contains_call() || right_child->contains_call();
+}
+
+auto VariableReferenceNode::contains_call() const -> bool
+{
+	return false;
+}
+
+auto TypedBinaryOperationNode::contains_call() const -> bool
+{
+	return left_child->contains_call() || right_child->contains_call();
+}
+
+auto TypedUnaryOperationNode::contains_call() const -> bool
+{
+	return child->contains_call();
 }
 
+auto FunctionCallNode::contains_call() const -> bool
+{
+	return true;
+}
+
+
+auto ExpressionNode::try_get_call() -> FunctionCallNode*
+{
+	return nullptr;
+}
+
+auto FunctionCallNode::try_get_call() -> FunctionCallNode*
+{
+	return this;
+}
+
+auto ExpressionNode::try_get_variable() -> VariableReferenceNode*
+{
+	return nullptr;
+}
+
+auto VariableReferenceNode::try_get_variable() -> VariableReferenceNode*
+{
+	return this;
+}
+
+auto ExpressionNode::try_get_binary_operation() -> BinaryOperationNode*
+{
+	return nullptr;
+}
+
+auto BinaryOperationNode::try_get_binary_operation() -> BinaryOperationNode*
+{
+	return this;
+}
+
+auto BinaryOperationNode::get_operation() const -> const OperationVariant&
+{
+	return this->operation_;
+}
+
+auto BinaryOperationNode::get_left_child() const -> ExpressionNode*
+{
+	return this->left_child;
+}
 
-void ResultNode::execute(ExecutionScopedState& execution_scoped_state) const
+auto BinaryOperationNode::get_right_child() const -> ExpressionNode*
 {
+	return this->right_child;
+}
+
+auto VariableReferenceNode::get_name() const -> Symbol
+{
+	return this->name;
+}
+
+
+void ResultNode::enable_tail_call()
+{
+	this->tail_call = this->result_expression->try_get_call();
+}
+
+auto ResultNode::execute(ExecutionScopedState& execution_scoped_state) const -> Completion
+{
+	if (this->tail_call != nullptr) {
+		this->tail_call->request_tail_call(execution_scoped_state);
+		return Completion::Return;
+	}
+
 	Value statement_result = this->result_expression->evaluate(execution_scoped_state);
 	execution_scoped_state.set_result(std::move(statement_result));
-	execution_scoped_state.mark_termination();
+	return Completion::Return;
 }
 
 
@@ -648,14 +1133,48 @@ void AstNode::print_padding(std::stringbuf& buf, const int32_t depth) const
 	}
 }
 
-void AstRoot::execute()
+auto AstRoot::get_tree_walker_limits(const ExecutionLimits& limits) -> ExecutionLimits
+{
+	// Deeper recursion would overflow the native stack before reaching the limit.
+	ExecutionLimits tree_walker_limits = limits;
+	tree_walker_limits.max_call_depth = std::min(limits.max_call_depth, max_native_call_depth);
+
+	return tree_walker_limits;
+}
+
+auto AstRoot::execute(const ExecutionLimits& limits, Profiler* profiler) -> MemoStatistics
 {
-	bool termination_token = false;
 	std::optional<Value> result;
-	ExecutionScopedState execution_state{ &termination_token, &result };
+	ValueStack stack;
+	ExecutionBudget budget{ get_tree_walker_limits(limits) };
+	MemoTable memo_table{ limits.memo_capacity };
+	ExecutionScopedState execution_state{ stack, budget, limits.memo_capacity > 0 ? &memo_table : nullptr, profiler, &result };
+
+	(void)this->head_statement->execute(execution_state);
 
-	this->head_statement->execute(execution_state);
+	print_result(result);
+	execution_state.print_summary();
+
+	return memo_table.get_statistics();
+}
 
+auto AstRoot::run(const ExecutionLimits& limits, const std::span<const Variable> inputs) const -> std::optional<Value>
+{
+	std::optional<Value> result;
+	ValueStack stack;
+	stack.variables.insert(stack.variables.end(), inputs.begin(), inputs.end());
+
+	ExecutionBudget budget{ get_tree_walker_limits(limits) };
+	MemoTable memo_table{ limits.memo_capacity };
+	ExecutionScopedState execution_state{ stack, budget, limits.memo_capacity > 0 ? &memo_table : nullptr, nullptr, &result };
+
+	(void)this->head_statement->execute(execution_state);
+
+	return result;
+}
+
+void AstRoot::print_result(const std::optional<Value>& result)
+{
 	if (result.has_value()) {
 		std::string str;
 		ValueVisitors::ValuePrinter printer{ &str };
@@ -666,147 +1185,258 @@ void AstRoot::execute()
 	} else {
 		std::cout << "Executed without result.\n";
 	}
-
-	execution_state.print_summary();
 }
 
-void VariableAssignmentNode::execute(ExecutionScopedState& context) const
+auto VariableAssignmentNode::execute(ExecutionScopedState& context) const -> Completion
 {
 	if (this->is_reassignment) // 
 	{
-		Value* value = context.try_get_var_value(this->variable_name);
+		Value* value = this->slot.is_dynamic()
+			? context.try_get_var_value(this->variable_name, this->cache)
+			: &context.get_var_value(this->slot);
 
 		if (value == nullptr) {
-			terminate_illegal_program("The value " + variable_name + "does not exist!");
+			terminate_illegal_program("The value " + std::string(symbols().get_name(variable_name)) + "does not exist!");
 		}
 
-		const Value var_value = this->expression->evaluate(context);
+		Value scratch;
+		const Value& new_value = this->expression->borrow(context, scratch);
+
+		// The call may have grown the value stack and moved the variable.
+		if (this->expression_contains_call) {
+			value = this->slot.is_dynamic()
+				? context.try_get_var_value(this->variable_name, this->cache)
+				: &context.get_var_value(this->slot);
+		}
 
-		value->reassign(var_value);
+		if (this->is_type_checked) {
+			*value = new_value;
+		}
+		else {
+			value->reassign(new_value);
+		}
 	}
 	else // New Variable
 	{
 		Value var_value = this->expression->evaluate(context);
+
+		if (this->is_redeclaration) {
+			terminate_illegal_program("Value with given name is already declared.");
+		}
+
 		Variable variable{ this->variable_name, std::move(var_value) };
-		context.declare_variable(std::move(variable));
+		context.push_variable(std::move(variable));
 	}
+
+	return Completion::Normal;
 }
 
-void MultiStatementsNode::execute(ExecutionScopedState& context) const
+auto BlockNode::execute(ExecutionScopedState& context) const -> Completion
 {
-	if (context.is_terminated()) {
-		return;
-	}
-
-	this->left_statement->execute(context);
+	for (const StatementNode* statement : this->statements)
+	{
+		const ProfiledScope profiled{ context.get_profiler(), *statement };
 
-	if (context.is_terminated()) {
-		return;
+		if (const Completion completion = statement->execute(context); completion != Completion::Normal) {
+			return completion;
+		}
 	}
 
-	this->right_statement->execute(context);
+	return Completion::Normal;
+}
+
+auto BodyNode::execute(ExecutionScopedState& context) const -> Completion
+{
+	return this->body_statement->execute(context);
 }
 
-void BodyNode::execute(ExecutionScopedState& context) const
+auto ConditionalStatementNode::evaluate_condition(const ExecutionScopedState& context) const -> bool
 {
-	this->body_statement->execute(context);
+	Value scratch;
+	const Value& condition_value = this->condition->borrow(context, scratch);
+
+	if (this->is_condition_checked) {
+		return condition_value.get_unchecked<bool>();
+	}
+
+	const bool* value_ptr = condition_value.try_get<bool>();
+
+	if (value_ptr == nullptr) {
+		terminate_illegal_program("Expression does not evaluate to boolean.");
+	}
+
+	return *value_ptr;
 }
 
-void ConditionalStatementNode::execute(ExecutionScopedState& parent_context) const
+template<typename TTest>
+auto ConditionalStatementNode::execute_while(ExecutionScopedState& parent_context, TTest test) const -> Completion
 {
-	auto should_continue = [&]() -> bool
+	for (;;)
 	{
-		// This is a hack.
-		// With current architecture, EVERY branching must manually check for termination!
-		if (parent_context.is_terminated()) {
-			return false;
-		}
+		{
+			ExecutionScopedState conditional_context{
+				&parent_context,
+				parent_context.get_result_target(),
+				parent_context.get_tail_call_target()
+			};
 
-		Value val = this->condition->evaluate(parent_context);
-		const bool* value_ptr = val.try_get<bool>();
+			if (!test()) {
+				return Completion::Normal;
+			}
 
-		if (value_ptr == nullptr) {
-			terminate_illegal_program("Expression does not evaluate to boolean.");
+			if (const Completion completion = this->statement->execute(conditional_context); completion != Completion::Normal) {
+				return completion;
+			}
 		}
 
-		return *value_ptr;
-	};
+		if (!this->repeating) {
+			return Completion::Normal;
+		}
 
-	constexpr auto iteration_cap = 1 << 13;
-	const auto max_iteration_count = this->repeating ? iteration_cap : 1;
+		parent_context.get_budget().charge();
+	}
+}
 
+auto ConditionalStatementNode::execute(ExecutionScopedState& parent_context) const -> Completion
+{
+	return this->execute_while(parent_context, [&]() -> bool {
+		return this->evaluate_condition(parent_context);
+	});
+}
+
+auto IncrementNode::execute(ExecutionScopedState& context) const -> Completion
+{
+	Value* value = this->slot.is_dynamic()
+		? context.try_get_var_value(this->variable_name, this->cache)
+		: &context.get_var_value(this->slot);
 
-	for (int i = 0; i < max_iteration_count; ++i) 
+	if (value == nullptr) {
+		terminate_illegal_program("The value " + std::string(symbols().get_name(variable_name)) + "does not exist!");
+	}
+
+	if (!this->is_type_checked && value->get_type() != Value::Type::Number) {
+		terminate_illegal_program("Left operand must a number to execute arithmetic operation.");
+	}
+
+	*value = Value(NumberArithmetic::add(value->get_unchecked<Value::Number>(), this->amount));
+	return Completion::Normal;
+}
+
+auto ComparisonLoopNode::execute(ExecutionScopedState& parent_context) const -> Completion
+{
+	const auto read = [&parent_context](const DirectOperand& operand, Value& scratch) -> const Value&
+	{
+		return operand.variable != nullptr ? operand.variable->borrow(parent_context, scratch) : operand.constant;
+	};
+
+	return this->loop->execute_while(parent_context, [&]() -> bool
 	{
-		ExecutionScopedState conditional_context{
-			&parent_context,
-			parent_context.get_termination_token(),
-			parent_context.get_result_target()
-		};
+		Value left_scratch;
+		Value right_scratch;
+		const Value& left_value = read(this->left, left_scratch);
+		const Value& right_value = read(this->right, right_scratch);
 
-		if (!should_continue()) {
-			return;
+		if (left_value.get_type() != Value::Type::Number || right_value.get_type() != Value::Type::Number) {
+			return this->loop->evaluate_condition(parent_context);
 		}
 
-		this->statement->execute(conditional_context);
-	}
+		const Value::Number l = left_value.get_unchecked<Value::Number>();
+		const Value::Number r = right_value.get_unchecked<Value::Number>();
 
-	if (this->repeating) {
-		terminate_illegal_program("Iteration count exceeded the limit.");
-	}
+		switch (this->operation) {
+			case ComparisonOperation::Equality:		return l == r;
+			case ComparisonOperation::Inequality:	return l != r;
+			case ComparisonOperation::Less:			return l < r;
+			case ComparisonOperation::LessOrEqual:	return l <= r;
+			case ComparisonOperation::More:			return l > r;
+			case ComparisonOperation::MoreOrEqual:	return l >= r;
+		}
+
+		terminate_illegal_program("Unknown comparison operation.");
+	});
 }
 
 
-void FunctionDeclarationNode::execute(ExecutionScopedState& context) const
+auto FunctionDeclarationNode::execute(ExecutionScopedState& context) const -> Completion
 {
-	const std::vector<std::string> args = this->args->get_list();
-	context.declare_function(Function{ this->name, this->body.get(), args });
+	context.declare_function(Function{ this->name, this->body, this->args->get_list(), this->traits });
+	return Completion::Normal;
 }
 
 
-auto FunctionCallNode::call(const ExecutionScopedState& context) const -> std::optional<Value>
+auto FunctionCallNode::find_function(const ExecutionScopedState& context) const -> const Function*
 {
-	const Function* function = context.try_get_function(this->name);
+	const Function* declared = context.try_get_function(this->name, this->cache);
 
-	if (function == nullptr) {
+	if (declared == nullptr) {
 		terminate_illegal_program("Function is not recognized.");
 	}
 
-	const std::vector<std::string> args = this->args->get_list();
-	std::optional<Value> value = function->call(const_cast<ExecutionScopedState&>(context), args); //TODO
+	return declared;
+}
+
+auto FunctionCallNode::call(const ExecutionScopedState& context) const -> std::optional<Value>
+{
+	const Function* declared = find_function(context);
+
+	// The declaration lives on the value stack, which the call itself may grow.
+	const Function function = *declared;
+	std::optional<Value> value = function.call(const_cast<ExecutionScopedState&>(context), *this->args); //TODO
 
 	return value;
 }
 
-auto FunctionCallNode::evaluate(const ExecutionScopedState& context) -> Value
+auto FunctionCallNode::borrow(const ExecutionScopedState& context, Value& scratch) -> const Value&
 {
+	// Calls made as statements are timed by their block.
+	const ProfiledScope profiled{ context.get_profiler(), *this };
 	std::optional<Value> result = call(context);
 
 	if (!result.has_value()) {
 		terminate_illegal_program("Function does not return anything.");
 	}
 
-	return result.value();
+	scratch = std::move(*result);
+	return scratch;
 }
 
-void FunctionCallNode::execute(ExecutionScopedState& context) const
+auto FunctionCallNode::execute(ExecutionScopedState& context) const -> Completion
 {
 	call(context);
+	return Completion::Normal;
+}
+
+void FunctionCallNode::request_tail_call(ExecutionScopedState& context) const
+{
+	TailCall& tail_call = *context.get_tail_call_target();
+
+	const Function* declared = find_function(context);
+	declared->check_call(context.get_budget(), this->args->get_list().size());
+	tail_call.function.emplace(*declared);
+
+	for (size_t i = 0; i < this->args->get_list().size(); ++i) {
+		tail_call.arguments.push_back(this->args->get_argument(context, i));
+	}
 }
 
-void PrintNode::execute(ExecutionScopedState& context) const
+auto PrintNode::execute(ExecutionScopedState& context) const -> Completion
 {
-	const Value* v = context.try_get_var_value(this->name);
+	const Value* v = this->slot.is_dynamic()
+		? context.try_get_var_value(this->name)
+		: &context.get_var_value(this->slot);
+
+	const std::string_view name_str = symbols().get_name(this->name);
 
 	if (v == nullptr) {
-		std::cout << this->name << " does not exist\n";
+		std::cout << name_str << " does not exist\n";
 	}
 
 	std::string target;
 	const ValueVisitors::ValuePrinter printer{ &target };
 	v->handle_by_visitor(printer);
 
-	std::cout << this->name << " = " << target << "\n";
+	std::cout << name_str << " = " << target << "\n";
+	return Completion::Normal;
 }
 
 
@@ -833,22 +1463,27 @@ void ArgsListNode::print(std::stringbuf& buf, int32_t depth) const
 }
 
 
-void ArgsListNode::append_list(std::vector<std::string>& list)
+auto ArgsListNode::get_list() const -> std::span<const Symbol>
 {
-	list.emplace_back(this->name);
+	return this->list;
+}
 
-	if (next) {
-		next->append_list(list);
-	}
+auto ArgsListNode::get_slots() const -> std::span<const VariableSlot>
+{
+	return this->slots;
 }
 
-auto ArgsListNode::get_list() -> std::vector<std::string>
+auto ArgsListNode::get_argument(const ExecutionScopedState& context, const size_t index) const -> const Value&
 {
-	std::vector<std::string> args;
+	const Value* value = this->slots[index].is_dynamic()
+		? context.try_get_var_value(this->list[index])
+		: &context.get_var_value(this->slots[index]);
 
-	append_list(args);
+	if (value == nullptr) {
+		terminate_illegal_program("Function argument " + std::string(symbols().get_name(this->list[index])) + " does not exist.");
+	}
 
-	return args;
+	return *value;
 }
 
 
@@ -886,7 +1521,22 @@ void VariableReferenceNode::print(std::stringbuf& buf, const int32_t depth) cons
 	print_padding(buf, depth);
 
 	append_str_buf(buf, "Ref: ");
-	append_str_buf(buf, name);
+	append_str_buf(buf, symbols().get_name(name));
+}
+
+void TypedBinaryOperationNode::print(std::stringbuf& buf, const int32_t depth) const
+{
+	print_padding(buf, depth);
+
+	this->left_child->print(buf, depth + 1);
+	this->right_child->print(buf, depth + 1);
+}
+
+void TypedUnaryOperationNode::print(std::stringbuf& buf, const int32_t depth) const
+{
+	print_padding(buf, depth);
+
+	this->child->print(buf, depth + 1);
 }
 
 void ResultNode::print(std::stringbuf& buf, const int32_t depth) const
@@ -903,22 +1553,23 @@ void VariableAssignmentNode::print(std::stringbuf& buf, const int32_t depth) con
 	print_padding(buf, depth);
 
 	if (is_reassignment) {
-		append_str_buf(buf, this->variable_name);
+		append_str_buf(buf, symbols().get_name(this->variable_name));
 		append_str_buf(buf, " := ...");
 	} else {
-		append_str_buf(buf, this->variable_name);
+		append_str_buf(buf, symbols().get_name(this->variable_name));
 		append_str_buf(buf, " = ...");
 	}
 }
 
-void MultiStatementsNode::print(std::stringbuf& buf, const int32_t depth) const
+void BlockNode::print(std::stringbuf& buf, const int32_t depth) const
 {
 	print_padding(buf, depth);
 
-	append_str_buf(buf, "L/R:");
+	append_str_buf(buf, "Block:");
 
-	this->right_statement->print(buf, depth + 1);
-	this->left_statement->print(buf, depth + 1);
+	for (const StatementNode* statement : this->statements) {
+		statement->print(buf, depth + 1);
+	}
 }
 
 void BodyNode::print(std::stringbuf& buf, const int32_t depth) const
@@ -941,6 +1592,20 @@ void ConditionalStatementNode::print(std::stringbuf& buf, const int32_t depth) c
 	this->condition->print(buf, depth + 1);
 }
 
+void IncrementNode::print(std::stringbuf& buf, const int32_t depth) const
+{
+	print_padding(buf, depth);
+
+	append_str_buf(buf, symbols().get_name(this->variable_name));
+	append_str_buf(buf, " += ");
+	append_str_buf(buf, std::to_string(this->amount));
+}
+
+void ComparisonLoopNode::print(std::stringbuf& buf, const int32_t depth) const
+{
+	this->loop->print(buf, depth);
+}
+
 void FunctionDeclarationNode::print(std::stringbuf& buf, const int32_t depth) const
 {
 	print_padding(buf, depth);
@@ -953,3 +1618,66 @@ void FunctionCallNode::print(std::stringbuf& buf, int32_t depth) const
 void PrintNode::print(std::stringbuf& buf, int32_t depth) const
 {
 }
+
+
+void StatementNode::set_location(const SourceRange& range)
+{
+	this->location = range;
+}
+
+auto StatementNode::get_location() const -> const SourceRange&
+{
+	return this->location;
+}
+
+auto BlockNode::describe() const -> std::string
+{
+	return "block";
+}
+
+auto BodyNode::describe() const -> std::string
+{
+	return "body";
+}
+
+auto ResultNode::describe() const -> std::string
+{
+	return "return";
+}
+
+auto VariableAssignmentNode::describe() const -> std::string
+{
+	const std::string name{ symbols().get_name(this->variable_name) };
+
+	return is_reassignment ? name + " =" : "let " + name;
+}
+
+auto ConditionalStatementNode::describe() const -> std::string
+{
+	return repeating ? "while" : "if";
+}
+
+auto IncrementNode::describe() const -> std::string
+{
+	return std::string(symbols().get_name(this->variable_name)) + " =";
+}
+
+auto ComparisonLoopNode::describe() const -> std::string
+{
+	return this->loop->describe();
+}
+
+auto FunctionDeclarationNode::describe() const -> std::string
+{
+	return "func " + std::string(symbols().get_name(this->name));
+}
+
+auto FunctionCallNode::describe() const -> std::string
+{
+	return "call " + std::string(symbols().get_name(this->name));
+}
+
+auto PrintNode::describe() const -> std::string
+{
+	return "print " + std::string(symbols().get_name(this->name));
+}
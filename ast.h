@@ -1,8 +1,10 @@
 #pragma once
 
-#include <memory>
+#include <atomic>
 #include <optional>
+#include <span>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -12,14 +14,32 @@
 #include "ast.h"
 #include "ast.h"
 #include "ast.h"
+#include "arena.h"
+#include "budget.h"
+#include "symbols.h"
 
 
 class AstNode;
 class StatementNode;
 class ExpressionNode;
+class FunctionCallNode;
+class BinaryOperationNode;
+class VariableReferenceNode;
+class BytecodeCompiler;
+class Resolver;
+class Folder;
+class TypeChecker;
 
 
-std::string str_to_cpp(const char* copy);
+[[noreturn]]
+void terminate_illegal_program(const std::string& reasoning);
+
+
+// --- Note ---
+// Value is a 16-byte tagged union. Logic and Number are stored inline, so copying
+// them is a plain copy of two words. Text lives out of line and is shared between
+// copies through a (non-atomic) reference count. It is copied only when a holder
+// asks for mutable access while other holders still see it.
 
 
 class Value final
@@ -29,8 +49,45 @@ public:
 	using Number = int32_t;
 	using Text = std::string;
 
+	enum class Type : uint8_t
+	{
+		Logic,
+		Number,
+		Text,
+	};
+
 private:
-	std::variant<Logic, Number, Text> value;
+	struct SharedText final
+	{
+		uint32_t references;
+		Text text;
+	};
+
+	union Payload
+	{
+		Logic logic;
+		Number number;
+		SharedText* text;
+	};
+
+	Payload payload{};
+	Type type = Type::Logic;
+
+	void retain() const noexcept
+	{
+		if (type == Type::Text) {
+			++payload.text->references;
+		}
+	}
+
+	void release() noexcept
+	{
+		if (type == Type::Text && --payload.text->references == 0) {
+			delete payload.text;
+		}
+	}
+
+	void detach_text();
 
 public:
 	explicit Value() = default;
@@ -39,54 +96,155 @@ public:
 	explicit Value(Number value);
 	explicit Value(Text text);
 
-	~Value() = default;
+	~Value()
+	{
+		release();
+	}
+
+	Value(const Value& other) noexcept
+		: payload(other.payload)
+		, type(other.type)
+	{
+		retain();
+	}
 
-	Value(const Value&) = default;
-	Value(Value&&) noexcept = default;
+	Value(Value&& other) noexcept
+		: payload(other.payload)
+		, type(other.type)
+	{
+		other.type = Type::Logic;
+	}
 
-	auto operator=(const Value&) -> Value& = default;
-	auto operator=(Value&&) noexcept -> Value& = default;
+	auto operator=(const Value& other) noexcept -> Value&
+	{
+		other.retain();
+		release();
+		payload = other.payload;
+		type = other.type;
+		return *this;
+	}
 
-	template<typename TVisitor>
-	void handle_by_visitor(TVisitor visitor)
+	auto operator=(Value&& other) noexcept -> Value&
 	{
-		std::visit(visitor, this->value);
+		if (this != &other) {
+			release();
+			payload = other.payload;
+			type = other.type;
+			other.type = Type::Logic;
+		}
+		return *this;
 	}
+
 	template<typename TVisitor>
 	void handle_by_visitor(TVisitor visitor) const
 	{
-		std::visit(visitor, this->value);
+		switch (type) {
+			case Type::Logic:	visitor(payload.logic); break;
+			case Type::Number:	visitor(payload.number); break;
+			case Type::Text:	visitor(static_cast<const Text&>(payload.text->text)); break;
+		}
 	}
 
 	template<typename T>
-	auto try_get() -> T*
+	auto try_get() const -> const T*
 	{
-		return std::get_if<T>(&value);
+		if constexpr (std::is_same_v<T, Logic>) {
+			return type == Type::Logic ? &payload.logic : nullptr;
+		}
+		else if constexpr (std::is_same_v<T, Number>) {
+			return type == Type::Number ? &payload.number : nullptr;
+		}
+		else {
+			static_assert(std::is_same_v<T, Text>, "Value holds only Logic, Number or Text.");
+			return type == Type::Text ? &payload.text->text : nullptr;
+		}
 	}
 
+	/// <summary>
+	///	Returns the logic or number value, which the caller knows to be of the type.
+	/// </summary>
 	template<typename T>
-	auto try_get() const -> const T*
+	auto get_unchecked() const -> T
 	{
-		return std::get_if<T>(&value);
+		if constexpr (std::is_same_v<T, Logic>) {
+			return payload.logic;
+		}
+		else {
+			static_assert(std::is_same_v<T, Number>, "Only Logic and Number are read unchecked.");
+			return payload.number;
+		}
+	}
+
+	template<typename T>
+	auto try_get() -> T*
+	{
+		if constexpr (std::is_same_v<T, Text>) {
+			if (type != Type::Text) {
+				return nullptr;
+			}
+
+			detach_text();
+			return &payload.text->text;
+		}
+		else {
+			return const_cast<T*>(static_cast<const Value&>(*this).try_get<T>());
+		}
+	}
+
+	[[nodiscard]]
+	auto get_type() const -> Type
+	{
+		return type;
 	}
 
 
 	void reassign(const Value& src);
+
+	[[nodiscard]]
+	auto to_string() const -> std::string;
 };
 
+static_assert(sizeof(Value) == 16, "Value is expected to fit in two words.");
+
+
+// Numbers wrap around on overflow, the same on every engine and in the machine code of the JIT.
+// The operations are done on unsigned integers, where wrapping around is defined.
+namespace NumberArithmetic
+{
+	constexpr auto add(const Value::Number l, const Value::Number r) -> Value::Number
+	{
+		return static_cast<Value::Number>(static_cast<uint32_t>(l) + static_cast<uint32_t>(r));
+	}
+
+	constexpr auto subtract(const Value::Number l, const Value::Number r) -> Value::Number
+	{
+		return static_cast<Value::Number>(static_cast<uint32_t>(l) - static_cast<uint32_t>(r));
+	}
+
+	constexpr auto multiply(const Value::Number l, const Value::Number r) -> Value::Number
+	{
+		return static_cast<Value::Number>(static_cast<uint32_t>(l) * static_cast<uint32_t>(r));
+	}
+
+	constexpr auto negate(const Value::Number value) -> Value::Number
+	{
+		return static_cast<Value::Number>(0u - static_cast<uint32_t>(value));
+	}
+}
+
 class Variable final
 {
-	std::string name;
+	Symbol name;
 	Value value;
 
 
 	Variable() = default;
 
 public:
-	explicit Variable(std::string name, Value init_value);
+	explicit Variable(Symbol name, Value init_value);
 
 	[[nodiscard]]
-	auto get_name() const -> const std::string&;
+	auto get_name() const -> Symbol;
 
 	[[nodiscard]]
 	auto get_value() const -> const Value&;
@@ -96,6 +254,43 @@ public:
 };
 
 class Function;
+struct TailCall;
+class MemoTable;
+struct MemoStatistics;
+class Profiler;
+
+
+/// <summary>
+///	Part of the source a node has been parsed from. Lines and columns count from 1, zeros mean unknown.
+/// </summary>
+struct SourceRange final
+{
+	uint32_t first_line = 0;
+	uint32_t first_column = 0;
+	uint32_t last_line = 0;
+	uint32_t last_column = 0;
+};
+
+
+// Location of a variable known ahead of execution: number of scopes to go up and the index within that scope.
+// Names free in a function body are bound by the caller (dynamic scope), so they are left dynamic.
+struct VariableSlot final
+{
+	static constexpr int32_t dynamic = -1;
+
+	int32_t depth = dynamic;
+	int32_t index = 0;
+
+	[[nodiscard]]
+	auto is_dynamic() const -> bool
+	{
+		return depth == dynamic;
+	}
+};
+
+
+// Type of an expression known before execution. Nothing when it is only known at runtime.
+using StaticType = std::optional<Value::Type>;
 
 
 enum class ArithmeticOperation
@@ -130,29 +325,152 @@ enum class UnaryOperation
 	Negate,
 };
 
+// Operation whose operand types have been checked ahead of execution.
+enum class TypedOperation : uint8_t
+{
+	NumberAddition,
+	NumberSubstraction,
+	NumberMultiplication,
+	NumberDivision,
+	NumberModulo,
+
+	NumberEquality,
+	NumberInequality,
+	NumberLess,
+	NumberLessOrEqual,
+	NumberMore,
+	NumberMoreOrEqual,
+
+	LogicAnd,
+	LogicOr,
+	LogicXor,
+	LogicEquality,
+	LogicInequality,
+};
 
-class ExecutionScopedState final
+/// <summary>
+///	Returns the type which both operands of the operation have.
+/// </summary>
+constexpr auto get_operand_type(const TypedOperation operation) -> Value::Type
 {
-	ExecutionScopedState* parent_state{};
+	return operation < TypedOperation::LogicAnd ? Value::Type::Number : Value::Type::Logic;
+}
+
+
+// --- Note ---
+// All scopes of one execution share a single ValueStack. A scope is only a window
+// over it: it owns whatever was pushed after it had been opened, and its destructor
+// pops that back off. Because scoping is dynamic, the chain of parent scopes is
+// exactly the stack itself, so a lookup by name scans it from the top.
+//
+// Pushing may reallocate the stack, so references into it must not be kept across
+// anything which may call a function.
+
+
+class ValueStack final
+{
+	// Stacks are created by compiles and runs on any thread, so only this is shared between them.
+	static inline std::atomic<uint64_t> last_identity = 0;
+
+public:
+	static constexpr size_t initial_capacity = 256;
+
 	std::vector<Variable> variables;
 	std::vector<Function> functions;
+
+	// Tells the stack apart from every other stack of the process, including those already destroyed.
+	const uint64_t identity;
+
+	// Changes whenever a function is pushed or popped. Never repeats within the stack.
+	uint64_t functions_epoch = 1;
+
+	// Changes whenever a variable is pushed or popped. Never repeats within the stack.
+	uint64_t variables_epoch = 1;
+
+	explicit ValueStack();
+
+	void bump_functions_epoch();
+
+	void bump_variables_epoch();
+};
+
+
+/// <summary>
+///	Position of the function a call site has found, valid while the same function stack keeps the same epoch.
+/// </summary>
+struct FunctionCache final
+{
+	uint64_t stack = 0;
+	uint64_t epoch = 0;
+	size_t index = 0;
+};
+
+/// <summary>
+///	Position of the variable a lookup by name has found, valid while the same variable stack keeps the same epoch.
+/// </summary>
+struct VariableCache final
+{
+	uint64_t stack = 0;
+	uint64_t epoch = 0;
+	size_t index = 0;
+};
+
+
+class ExecutionScopedState final
+{
+	ExecutionScopedState* parent_state{};
+	ValueStack* stack;
+	ExecutionBudget* budget;
+	MemoTable* memo_table;
+	Profiler* profiler;
+	size_t variables_base;
+	size_t functions_base;
 	std::optional<Value>* result;
-	bool* termination_token;
+	TailCall* tail_call = nullptr;
 	int level = 0;
 
 public:
-	explicit ExecutionScopedState(bool* termination_token, std::optional<Value>* result);
+	explicit ExecutionScopedState(ValueStack& stack, ExecutionBudget& budget, MemoTable* memo_table, Profiler* profiler, std::optional<Value>* result);
+
+	explicit ExecutionScopedState(ExecutionScopedState* parent_state, std::optional<Value>* result, TailCall* tail_call);
+
+	~ExecutionScopedState();
+
+	ExecutionScopedState(const ExecutionScopedState&) = delete;
+	ExecutionScopedState(ExecutionScopedState&&) = delete;
+
+	auto operator=(const ExecutionScopedState&) -> ExecutionScopedState& = delete;
+	auto operator=(ExecutionScopedState&&) -> ExecutionScopedState& = delete;
+
+	auto try_get_var_value(Symbol name) -> Value*;
+
+	auto try_get_var_value(Symbol name) const -> const Value*;
 
-	explicit ExecutionScopedState(ExecutionScopedState* parent_state, bool* termination_token, std::optional<Value>* result);
+	/// <summary>
+	///	Finds the variable like try_get_var_value, skipping the search when the cache is still valid.
+	/// </summary>
+	auto try_get_var_value(Symbol name, VariableCache& cache) -> Value*;
 
-	auto try_get_var_value(std::string_view name) -> Value*;
+	auto try_get_var_value(Symbol name, VariableCache& cache) const -> const Value*;
 
-	auto try_get_var_value(std::string_view name) const -> const Value*;
+	auto try_get_function(Symbol name) const -> const Function*;
 
-	auto try_get_function(std::string_view name) const -> const Function*;
+	/// <summary>
+	///	Finds the function like try_get_function, skipping the search when the cache is still valid.
+	/// </summary>
+	auto try_get_function(Symbol name, FunctionCache& cache) const -> const Function*;
+
+	auto get_var_value(VariableSlot slot) -> Value&;
+
+	auto get_var_value(VariableSlot slot) const -> const Value&;
 
 	void declare_variable(Variable&& variable);
 
+	/// <summary>
+	///	Declares a variable which the resolver has already checked against redeclaration.
+	/// </summary>
+	void push_variable(Variable&& variable);
+
 	void declare_function(Function&& function);
 
 	void set_result(Value&& value);
@@ -161,11 +479,22 @@ public:
 
 	auto get_result_target() -> std::optional<Value>*;
 
-	void mark_termination();
+	/// <summary>
+	///	Returns where a tail call of the innermost function is left. Null outside of functions.
+	/// </summary>
+	auto get_tail_call_target() const -> TailCall*;
 
-	auto is_terminated() const -> bool;
+	auto get_budget() const -> ExecutionBudget&;
 
-	auto get_termination_token() const-> bool*;
+	/// <summary>
+	///	Returns the results of pure calls made so far. Null when memoization is off.
+	/// </summary>
+	auto get_memo_table() const -> MemoTable*;
+
+	/// <summary>
+	///	Returns the profiler timing the statements. Null unless profiling.
+	/// </summary>
+	auto get_profiler() const -> Profiler*;
 
 	void print_summary();
 };
@@ -174,11 +503,10 @@ public:
 // --- Note ---
 // Bison (for C) is not compatible with move-only types such as unique_ptr.
 // When the union uses move-only types, it fails to be copied in Bison's internals.
-// To mitigate this issue, the union uses raw pointer. Of course, this solution
-// is regarded unsafe in C++ world. Therefor all nodes take raw pointers to children
-// as constructor parameters. Then such parent takes ownership by wrapping the
-// incoming chin in unique_ptr. A child must never be passed to multiple parents.
-// Such operation does not makes sense conceptually and can corrupt memory.
+// To mitigate this issue, the union uses raw pointer. All nodes are created in
+// the Arena of the program and live exactly as long as it does. Parents only
+// refer to their children; nobody deletes a node. Therefor nodes must never
+// be created with plain new, and their destructors are not virtual.
 
 
 class AstNode
@@ -186,21 +514,64 @@ class AstNode
 protected:
 	virtual void print_padding(std::stringbuf& buf, int32_t depth = 0) const;
 
-public:
-	virtual ~AstNode() = default;
+	~AstNode() = default;
 
+public:
 	virtual void print(std::stringbuf& buf, int32_t depth = 0) const = 0;
 };
 
 class AstRoot final : public AstNode
 {
-	std::unique_ptr<StatementNode> head_statement;
+	StatementNode* head_statement;
 
 public:
+	// Calls the tree walker may nest, whatever the limits allow. Each one takes up to a kilobyte of the native stack.
+	static constexpr uint32_t max_native_call_depth = 4096;
+
 	explicit AstRoot(StatementNode*);
 
 
-	void execute();
+	/// <summary>
+	///	Returns the limits lowered to what the tree walker can honour.
+	/// </summary>
+	[[nodiscard]]
+	static auto get_tree_walker_limits(const ExecutionLimits& limits) -> ExecutionLimits;
+
+	/// <summary>
+	///	Executes the program on the tree walker and prints the outcome. The profiler, if given, times every statement.
+	/// </summary>
+	auto execute(const ExecutionLimits& limits, Profiler* profiler = nullptr) -> MemoStatistics;
+
+	/// <summary>
+	///	Executes the program on the tree walker without printing anything. The inputs are visible
+	///	to the program like variables of a scope enclosing it. Returns the value of the top-level return, if any.
+	/// </summary>
+	auto run(const ExecutionLimits& limits, std::span<const Variable> inputs) const -> std::optional<Value>;
+
+	auto execute_bytecode(const ExecutionLimits& limits) const -> MemoStatistics;
+
+	void compile(BytecodeCompiler&) const;
+
+	/// <summary>
+	///	Prints the line reporting what the program returned. Shared by all ways of executing a program.
+	/// </summary>
+	static void print_result(const std::optional<Value>& result);
+
+	/// <summary>
+	///	Binds variables to their scope slots and analyses the functions. Must run before either engine executes the program.
+	/// </summary>
+	void resolve();
+
+	/// <summary>
+	///	Folds constant expressions and prunes dead branches. Replacement nodes are created in the arena.
+	/// </summary>
+	void fold(Arena&);
+
+	/// <summary>
+	///	Infers the types of expressions and replaces operations on known types with typed nodes, created in the arena.
+	///	Runs after resolve. Returns the type errors found, the program must not be executed when there are any.
+	/// </summary>
+	auto check_types(Arena&) -> std::vector<std::string>;
 
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
@@ -211,19 +582,43 @@ public:
 
 class ArgsListNode final : public AstNode
 {
-	std::string name;
-	std::unique_ptr<ArgsListNode> next;
-
-	void append_list(std::vector<std::string>&);
+	std::span<const Symbol> list;
+	std::span<VariableSlot> slots;
 
 public:
-	explicit ArgsListNode(std::string name);
-
-	explicit ArgsListNode(std::string name, ArgsListNode* next);
+	/// <summary>
+	///	Copies the names, given in the order they are written, into the arena.
+	/// </summary>
+	explicit ArgsListNode(Arena& arena, std::span<const Symbol> names);
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	auto get_list() -> std::vector<std::string>;
+	/// <summary>
+	///	Returns names of the whole list, starting with the last one written.
+	/// </summary>
+	auto get_list() const -> std::span<const Symbol>;
+
+	/// <summary>
+	///	Returns slots of the names, matching the list. Names used as call arguments are bound by the resolver.
+	/// </summary>
+	auto get_slots() const -> std::span<const VariableSlot>;
+
+	/// <summary>
+	///	Returns the value passed as the argument at the index, as seen from the calling scope.
+	/// </summary>
+	auto get_argument(const ExecutionScopedState&, size_t index) const -> const Value&;
+
+	void resolve(Resolver&);
+};
+
+
+/// <summary>
+///	Expression after type checking: the node which replaces it and its type.
+/// </summary>
+struct InferredExpression final
+{
+	ExpressionNode* node;
+	StaticType type;
 };
 
 
@@ -235,14 +630,64 @@ protected:
 	void ensure_parent(const ExpressionNode&) const;
 
 public:
-	virtual auto evaluate(const ExecutionScopedState&) -> Value = 0;
-
-	~ExpressionNode() override = default;
+	/// <summary>
+	///	Evaluates the expression into a value owned by the caller.
+	/// </summary>
+	auto evaluate(const ExecutionScopedState&) -> Value;
+
+	/// <summary>
+	///	Evaluates the expression without copying. Returns a value owned by the tree or by a scope,
+	///	or the scratch after storing a temporary result in it. A borrowed variable reflects later
+	///	reassignments, so it must be copied before anything which may call a function is evaluated.
+	/// </summary>
+	virtual auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& = 0;
+
+	/// <summary>
+	///	Emits code computing the expression. Returns the register holding the result.
+	/// </summary>
+	virtual auto compile_expression(BytecodeCompiler&) const -> uint16_t = 0;
+
+	/// <summary>
+	///	Checks if evaluation may call a function (and so observe or modify variables through dynamic scope).
+	/// </summary>
+	virtual auto contains_call() const -> bool = 0;
+
+	virtual void resolve(Resolver&) = 0;
+
+	/// <summary>
+	///	Simplifies the subtree. Returns the node which replaces this one.
+	/// </summary>
+	virtual auto fold_expression(Folder&) -> ExpressionNode* = 0;
+
+	/// <summary>
+	///	Finds the type of the expression, reporting operations which can not succeed.
+	/// </summary>
+	virtual auto infer_expression(TypeChecker&) -> InferredExpression = 0;
+
+	/// <summary>
+	///	Returns the value of the expression when it is known without execution.
+	/// </summary>
+	virtual auto try_get_constant() const -> const Value*;
+
+	/// <summary>
+	///	Returns the call when the whole expression is a single function call.
+	/// </summary>
+	virtual auto try_get_call() -> FunctionCallNode*;
+
+	/// <summary>
+	///	Returns the variable when the whole expression is a single variable reference.
+	/// </summary>
+	virtual auto try_get_variable() -> VariableReferenceNode*;
+
+	/// <summary>
+	///	Returns the operation when the whole expression is a single binary operation.
+	/// </summary>
+	virtual auto try_get_binary_operation() -> BinaryOperationNode*;
 };
 
 class BraceExpressionNode final : public ExpressionNode
 {
-	std::unique_ptr<ExpressionNode> braced_expression;
+	ExpressionNode* braced_expression;
 
 
 public:
@@ -250,7 +695,17 @@ public:
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	auto evaluate(const ExecutionScopedState&) -> Value override;
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
 };
 
 class LiteralNode final : public ExpressionNode
@@ -261,26 +716,63 @@ class LiteralNode final : public ExpressionNode
 public:
 	explicit LiteralNode(Value&& value);
 
-	auto evaluate(const ExecutionScopedState&) -> Value override;
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
 
-	auto print(std::stringbuf& buf, int32_t depth) const -> void override;
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
 
-	~LiteralNode() override = default;
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
+
+	auto try_get_constant() const -> const Value* override;
+
+	auto print(std::stringbuf& buf, int32_t depth) const -> void override;
 };
 
+// --- Note ---
+// Operations which type checking could not prove learn their types while running.
+// An operation remembers the operand types it sees the first time, and as long as
+// the operands keep them, it computes the result the way a typed node would. Other
+// types send it back to the checked path, which fails or copes with them as before.
+// Operations whose types keep changing stop learning after max_quickenings attempts.
+// Lookups by name remember where they have found the variable, see VariableCache.
+// This state lives in the nodes and is written without synchronisation, so a tree is
+// executed by one thread at a time.
+// A condition is quickened through its expression, usually a comparison; telling
+// whether the result is a logic value takes a single comparison of the tag anyway.
+
+constexpr uint8_t max_quickenings = 4;
+
+
 class UnaryOperationNode final : public ExpressionNode
 {
 public:
 	explicit UnaryOperationNode(UnaryOperation op, ExpressionNode* child);
 
-	auto evaluate(const ExecutionScopedState&) -> Value override;
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
 
 private:
 	UnaryOperation operator_;
-	std::unique_ptr<ExpressionNode> child;
+	ExpressionNode* child;
+	bool is_quickened = false;	// The operand has been of the type the operator takes.
+	uint8_t quickenings = 0;
 };
 
 class BinaryOperationNode final : public ExpressionNode
@@ -297,55 +789,206 @@ public:
 		ExpressionNode* right
 	);
 
-	auto evaluate(const ExecutionScopedState&) -> Value override;
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
+	auto try_get_binary_operation() -> BinaryOperationNode* override;
+
+	/// <summary>
+	///	Returns the typed operation which computes this one for operands of the given type, if any can.
+	/// </summary>
+	[[nodiscard]]
+	auto get_typed_operation(Value::Type operand_type) const -> std::optional<TypedOperation>;
+
+	[[nodiscard]]
+	auto get_operation() const -> const OperationVariant&;
+
+	[[nodiscard]]
+	auto get_left_child() const -> ExpressionNode*;
+
+	[[nodiscard]]
+	auto get_right_child() const -> ExpressionNode*;
+
 private:
 	OperationVariant operation_;
-	std::unique_ptr<ExpressionNode> left_child;
-	std::unique_ptr<ExpressionNode> right_child;
+	ExpressionNode* left_child;
+	ExpressionNode* right_child;
+	bool right_contains_call;
+	std::optional<TypedOperation> quickened;	// Used while the operands keep the type it takes.
+	uint8_t quickenings = 0;
 };
 
 class VariableReferenceNode final : public ExpressionNode
 {
-	std::string name;
+	Symbol name;
+	VariableSlot slot;
+	VariableCache cache;
+
+public:
+	explicit VariableReferenceNode(Symbol name);
+
+	void print(std::stringbuf& buf, int32_t depth) const override;
+
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
+
+	auto try_get_variable() -> VariableReferenceNode* override;
+
+	[[nodiscard]]
+	auto get_name() const -> Symbol;
+};
+
+
+/// <summary>
+///	Binary operation on operands known to be of the right types. Produced by type checking.
+/// </summary>
+class TypedBinaryOperationNode final : public ExpressionNode
+{
+	TypedOperation operation;
+	ExpressionNode* left_child;
+	ExpressionNode* right_child;
 
 public:
-	explicit VariableReferenceNode(std::string&& name);
+	explicit TypedBinaryOperationNode(TypedOperation operation, ExpressionNode* left, ExpressionNode* right);
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	auto evaluate(const ExecutionScopedState&) -> Value override;
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
+};
+
+/// <summary>
+///	Unary operation on an operand known to be of the right type. Produced by type checking.
+/// </summary>
+class TypedUnaryOperationNode final : public ExpressionNode
+{
+	UnaryOperation operation;
+	ExpressionNode* child;
+
+public:
+	explicit TypedUnaryOperationNode(UnaryOperation operation, ExpressionNode* child);
+
+	void print(std::stringbuf& buf, int32_t depth) const override;
+
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
+};
+
+
+/// <summary>
+///	How a statement has finished. Anything but Normal skips the rest of the enclosing statements,
+///	up to the one which handles it: a return ends the innermost function, or the program.
+/// </summary>
+enum class Completion : uint8_t
+{
+	Normal,
+	Return,
 };
 
 
 class StatementNode : public AstNode
 {
+	SourceRange location;
+
 public:
-	virtual void execute(ExecutionScopedState&) const = 0;
+	[[nodiscard]]
+	virtual auto execute(ExecutionScopedState&) const -> Completion = 0;
+
+	virtual void compile_statement(BytecodeCompiler&) const = 0;
+
+	virtual void resolve(Resolver&) = 0;
+
+	/// <summary>
+	///	Simplifies the subtree. Returns the node which replaces this one, or null when the statement has no effect.
+	/// </summary>
+	virtual auto fold_statement(Folder&) -> StatementNode* = 0;
+
+	/// <summary>
+	///	Checks the types within the statement and replaces its expressions with typed ones.
+	/// </summary>
+	virtual void check_types(TypeChecker&) = 0;
+
+	/// <summary>
+	///	Names the statement in reports, like "while" or "call f".
+	/// </summary>
+	[[nodiscard]]
+	virtual auto describe() const -> std::string = 0;
+
 
-	~StatementNode() override = default;
+	void set_location(const SourceRange& range);
+
+	[[nodiscard]]
+	auto get_location() const -> const SourceRange&;
 };
 
-class MultiStatementsNode final : public StatementNode
+class BlockNode final : public StatementNode
 {
-	std::unique_ptr<StatementNode> left_statement;
-	std::unique_ptr<StatementNode> right_statement;
+	std::span<StatementNode* const> statements;
 
-	MultiStatementsNode() = default;
+	BlockNode() = default;
 
 public:
-	explicit MultiStatementsNode(StatementNode* left_statement, StatementNode* right_statement);
+	/// <summary>
+	///	Copies the sequence of statements into the arena.
+	/// </summary>
+	explicit BlockNode(Arena& arena, std::span<StatementNode* const> statements);
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	void execute(ExecutionScopedState&) const override;
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 };
 
 class BodyNode final : public StatementNode
 {
-	std::unique_ptr<StatementNode> body_statement;
+	StatementNode* body_statement;
 
 	BodyNode() = default;
 
@@ -354,44 +997,84 @@ public:
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	void execute(ExecutionScopedState&) const override;
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 };
 
 class ResultNode final : public StatementNode
 {
-	std::unique_ptr<ExpressionNode> result_expression;
+	ExpressionNode* result_expression;
+	FunctionCallNode* tail_call = nullptr;
 
 	ResultNode() = default;
 
 public:
 	explicit ResultNode(ExpressionNode* result_expression);
 
-	void execute(ExecutionScopedState&) const override;
+	/// <summary>
+	///	Lets the returned call replace the frame of the function. Set by the resolver, only where it can not be observed.
+	/// </summary>
+	void enable_tail_call();
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	~ResultNode() override = default;
+	auto describe() const -> std::string override;
 };
 
 class VariableAssignmentNode final : public StatementNode
 {
-	std::string variable_name;
-	std::unique_ptr<ExpressionNode> expression;
+	Symbol variable_name;
+	ExpressionNode* expression;
 	bool is_reassignment;
+	bool expression_contains_call;
+	bool is_redeclaration = false;
+	bool is_type_checked = false;	// The reassigned value is known to have the type of the variable.
+	VariableSlot slot;
+	mutable VariableCache cache;
 
 public:
-	explicit VariableAssignmentNode(std::string variable_name, ExpressionNode* expression, bool reassignment);
+	explicit VariableAssignmentNode(Symbol variable_name, ExpressionNode* expression, bool reassignment);
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	void execute(ExecutionScopedState& context) const override;
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState& context) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 };
 
 class ConditionalStatementNode final : public StatementNode
 {
-	std::unique_ptr<ExpressionNode> condition;
-	std::unique_ptr<StatementNode> statement;
+	ExpressionNode* condition;
+	StatementNode* statement;
 	bool repeating;
+	bool is_condition_checked = false;	// The condition is known to be a logic value.
 
 	ConditionalStatementNode() = default;
 
@@ -403,83 +1086,285 @@ public:
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	void execute(ExecutionScopedState&) const override;
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
+
+	/// <summary>
+	///	Evaluates the condition, which must be a logic value.
+	/// </summary>
+	auto evaluate_condition(const ExecutionScopedState&) const -> bool;
+
+	/// <summary>
+	///	Runs the statement in a scope of its own while the given test passes, once unless repeating.
+	/// </summary>
+	template<typename TTest>
+	auto execute_while(ExecutionScopedState& parent_context, TTest test) const -> Completion;
+};
+
+
+// --- Note ---
+// Some statements are common enough to get nodes of their own, made by folding:
+//
+//	i = i + 1;			an IncrementNode adds the number to the variable in place,
+//	while i < n { }		a ComparisonLoopNode compares two numbers directly.
+//
+// Both read their variables directly and check a single type tag instead of going
+// through operation nodes, so a counting loop takes only a few instructions per step.
+// When the types are not numbers, they fall back to the checks of the statement they
+// replace, so errors stay the same. Bytecode is still compiled from the replaced loop.
+
+
+/// <summary>
+///	Operand of a fused node: a variable, or the constant when there is no variable.
+/// </summary>
+struct DirectOperand final
+{
+	VariableReferenceNode* variable = nullptr;
+	Value constant;
+};
+
+/// <summary>
+///	Reassignment which adds a number to the variable it reads, like `i = i + 1` or `i = i - 2`.
+/// </summary>
+class IncrementNode final : public StatementNode
+{
+	Symbol variable_name;
+	Value::Number amount;	// Subtraction adds the negated number.
+	bool is_type_checked = false;	// The variable is known to be a number.
+	VariableSlot slot;
+	mutable VariableCache cache;
+
+public:
+	explicit IncrementNode(Symbol variable_name, Value::Number amount);
+
+	void print(std::stringbuf& buf, int32_t depth) const override;
+
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState& context) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 };
 
+/// <summary>
+///	Loop whose condition compares two numbers, each a variable or a literal, like `while i < n`.
+/// </summary>
+class ComparisonLoopNode final : public StatementNode
+{
+	ConditionalStatementNode* loop;
+	ComparisonOperation operation;
+	DirectOperand left;
+	DirectOperand right;
+
+public:
+	explicit ComparisonLoopNode(ConditionalStatementNode* loop, ComparisonOperation operation, DirectOperand left, DirectOperand right);
+
+	void print(std::stringbuf& buf, int32_t depth) const override;
+
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
+};
+
+// --- Note ---
+// Every call of the tree walker nests on the native stack, so the depth of calls in
+// progress is limited (see ExecutionLimits). A function ending with `return f(...)`
+// does not need its frame anymore, unless the callee could still find its variables
+// by name (the scope is dynamic). When the resolver proves it can not, the returned
+// call is left to the Function::call which runs the frame. It replaces the frame
+// with the one of the callee in a loop, so tail recursion runs in constant space.
+
+
+/// <summary>
+///	What the resolver has found out about a declared function.
+/// </summary>
+struct FunctionTraits final
+{
+	bool is_pure = false;
+
+	// Pure, and costly enough (it loops or calls) for a lookup of its inputs to pay off.
+	bool is_memoized = false;
+
+	// Free names read by the function or by anything it calls. Their values are inputs of a pure function.
+	std::vector<Symbol> free_reads;
+};
+
+
 class Function final
 {
-	std::string name;
+	Symbol name;
 	StatementNode* body;
-	std::vector<std::string> signature;
+	std::span<const Symbol> signature;
+	const FunctionTraits* traits;
 
 	Function() = default;
 
+	/// <summary>
+	///	Gathers the arguments and free reads into the probe. Returns false when a free name is missing.
+	/// </summary>
+	auto gather_inputs(const ExecutionScopedState&, const ArgsListNode& args, std::vector<Value>& probe) const -> bool;
+
 public:
-	using Signature = std::vector<std::string>;
+	using Signature = std::span<const Symbol>;
+
+	explicit Function(Symbol name, StatementNode* body, Signature signature, const FunctionTraits& traits);
 
-	explicit Function(std::string name, StatementNode* body, Signature signature);
+	/// <summary>
+	///	Charges the budget and checks the arity. Done before the arguments are bound.
+	/// </summary>
+	void check_call(ExecutionBudget&, size_t argument_count) const;
 
-	auto call(ExecutionScopedState&, const std::vector<std::string>& args) const -> std::optional<Value>;
+	auto call(ExecutionScopedState&, const ArgsListNode& args) const -> std::optional<Value>;
 
-	auto get_name() const -> const std::string&;
+	auto get_name() const -> Symbol;
+};
+
+
+/// <summary>
+///	Call which a function returns directly. It is performed by Function::call after the frame of the returning function is gone.
+/// </summary>
+struct TailCall final
+{
+	std::optional<Function> function;
+	std::vector<Value> arguments;
 };
 
 
 
 class FunctionDeclarationNode final : public StatementNode
 {
-	std::string name;
-	std::unique_ptr<StatementNode> body;
-	std::unique_ptr<ArgsListNode> args;
+	Symbol name;
+	StatementNode* body;
+	ArgsListNode* args;
+	FunctionTraits traits;
 
 	FunctionDeclarationNode() = default;
 
 public:
 	explicit FunctionDeclarationNode(
-		std::string name, 
+		Symbol name,
 		StatementNode* body_node,
 		ArgsListNode* args
 	);
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	void execute(ExecutionScopedState&) const override;
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 };
 
 class FunctionCallNode final : public ExpressionNode, public StatementNode
 {
-	std::string name;
-	std::unique_ptr<ArgsListNode> args;
+	Symbol name;
+	ArgsListNode* args;
+	mutable FunctionCache cache;
 
 	FunctionCallNode() = default;
 
 	auto call(const ExecutionScopedState&) const -> std::optional<Value>;
 
+	auto find_function(const ExecutionScopedState&) const -> const Function*;
+
+	auto compile_call(BytecodeCompiler&, bool requires_result, bool is_tail_call) const -> uint16_t;
+
 public:
 	explicit FunctionCallNode(
-		std::string name,
+		Symbol name,
 		ArgsListNode* args
 	);
 
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	auto evaluate(const ExecutionScopedState&) -> Value override;
+	auto describe() const -> std::string override;
+
+	auto borrow(const ExecutionScopedState&, Value& scratch) -> const Value& override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	/// <summary>
+	///	Finds the function and evaluates the arguments, leaving the call to the enclosing Function::call.
+	/// </summary>
+	void request_tail_call(ExecutionScopedState&) const;
+
+	auto compile_expression(BytecodeCompiler&) const -> uint16_t override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	/// <summary>
+	///	Emits a call which may replace the frame of the running function. The result is returned right after.
+	/// </summary>
+	void compile_tail_call(BytecodeCompiler&) const;
+
+	auto contains_call() const -> bool override;
+
+	void resolve(Resolver&) override;
 
-	void execute(ExecutionScopedState&) const override;
+	auto fold_expression(Folder&) -> ExpressionNode* override;
+
+	auto infer_expression(TypeChecker&) -> InferredExpression override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
+
+	auto try_get_call() -> FunctionCallNode* override;
 };
 
 class PrintNode final : public StatementNode
 {
-	std::string name;
+	Symbol name;
+	VariableSlot slot;
 
 
 	PrintNode() = default;
 
 public:
-	explicit PrintNode(std::string name);
+	explicit PrintNode(Symbol name);
 
 	void print(std::stringbuf& buf, int32_t depth) const override;
 
-	void execute(ExecutionScopedState&) const override;
+	auto describe() const -> std::string override;
+
+	auto execute(ExecutionScopedState&) const -> Completion override;
+
+	void compile_statement(BytecodeCompiler&) const override;
+
+	void resolve(Resolver&) override;
+
+	auto fold_statement(Folder&) -> StatementNode* override;
+
+	void check_types(TypeChecker&) override;
 };
@@ -0,0 +1,340 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+#include "arena.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "lexing.h"
+#include "vm.h"
+
+
+// --- Note ---
+// Measures the phases of running a program, one workload at a time: scanning alone,
+// parsing (which includes scanning), and executing on each engine. A phase is repeated
+// until it has run for the minimal time, and the averages per repetition are printed
+// as JSON. Allocations are counted by replacing the global operator new.
+//
+// Executions run a tree which has been parsed, folded and resolved once, outside of
+// the measured loop. Whatever the programs print is discarded.
+
+
+// Defined by the reentrant scanner flex generates.
+auto yylex(YYSTYPE* yylval, YYLTYPE* yylloc, yyscan_t scanner) -> int;
+auto yylex_init_extra(LexerUtil* extra, yyscan_t* scanner) -> int;
+auto yy_scan_bytes(const char* bytes, int length, yyscan_t scanner) -> struct yy_buffer_state*;
+auto yylex_destroy(yyscan_t scanner) -> int;
+
+
+uint64_t allocation_count = 0;
+uint64_t allocated_bytes = 0;
+
+auto counted_allocate(const std::size_t size) -> void*
+{
+	++allocation_count;
+	allocated_bytes += size;
+
+	if (void* memory = std::malloc(size != 0 ? size : 1)) {
+		return memory;
+	}
+
+	throw std::bad_alloc();
+}
+
+auto operator new(const std::size_t size) -> void*
+{
+	return counted_allocate(size);
+}
+
+auto operator new[](const std::size_t size) -> void*
+{
+	return counted_allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+
+struct Workload final
+{
+	std::string name;
+	std::string source;
+};
+
+struct Measurement final
+{
+	uint64_t iterations = 0;
+	double ns_per_op = 0;
+	double allocations_per_op = 0;
+	double bytes_per_op = 0;
+};
+
+
+// Swallows the output of the measured programs.
+class NullBuffer final : public std::streambuf
+{
+protected:
+	auto overflow(const int_type character) -> int_type override
+	{
+		return traits_type::not_eof(character);
+	}
+
+	auto xsputn(const char*, const std::streamsize count) -> std::streamsize override
+	{
+		return count;
+	}
+};
+
+
+auto read_file(const std::string& path) -> std::string
+{
+	std::ifstream file{ path, std::ios::binary };
+
+	if (!file) {
+		throw std::runtime_error("Can not read " + path);
+	}
+
+	return { std::istreambuf_iterator<char>{ file }, {} };
+}
+
+// The examples hold a readable program followed by the same program on its last line.
+auto read_last_line(const std::string& path) -> std::string
+{
+	const std::string contents = read_file(path);
+	const size_t end = contents.find_last_not_of("\r\n");
+	const size_t start = contents.find_last_of('\n', end);
+
+	return contents.substr(start == std::string::npos ? 0 : start + 1, end - (start == std::string::npos ? 0 : start + 1) + 1);
+}
+
+auto make_deep_recursion(const int depth) -> std::string
+{
+	return "func down(n) { if n > 0 { let m = n - 1; let r = down(m); }; return n; }; "
+		"let d = " + std::to_string(depth) + "; let x = down(d);";
+}
+
+auto make_deep_nesting(const int depth) -> std::string
+{
+	std::string source = "let c = true; ";
+
+	for (int i = 0; i < depth; ++i) {
+		source += "if c { let v" + std::to_string(i) + " = " + std::to_string(i) + "; ";
+	}
+
+	source += "let s = 0; let i = 0; while i < 1000 { s = s + v0; i = i + 1; }; ";
+
+	for (int i = 0; i < depth; ++i) {
+		source += "}; ";
+	}
+
+	return source;
+}
+
+auto make_straight_line(const int length) -> std::string
+{
+	std::string source = "let s = 0; ";
+
+	for (int i = 0; i < length; ++i) {
+		source += "s = s + " + std::to_string(i % 10) + "; ";
+	}
+
+	return source;
+}
+
+auto get_peak_rss_kilobytes() -> uint64_t
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+}
+
+
+auto measure(const std::function<void()>& operation, const std::chrono::nanoseconds min_time) -> Measurement
+{
+	operation();
+
+	const uint64_t allocations_before = allocation_count;
+	const uint64_t bytes_before = allocated_bytes;
+	const auto start = std::chrono::steady_clock::now();
+	auto elapsed = std::chrono::steady_clock::duration::zero();
+	uint64_t iterations = 0;
+
+	do {
+		operation();
+		++iterations;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed < min_time);
+
+	const auto count = static_cast<double>(iterations);
+
+	return Measurement{
+		iterations,
+		static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / count,
+		static_cast<double>(allocation_count - allocations_before) / count,
+		static_cast<double>(allocated_bytes - bytes_before) / count,
+	};
+}
+
+void lex(const std::string& source)
+{
+	LexerUtil lexer_util;
+	lexer_util.set_multiline(true);
+
+	yyscan_t scanner = nullptr;
+	yylex_init_extra(&lexer_util, &scanner);
+	yy_scan_bytes(source.data(), static_cast<int>(source.size()), scanner);
+
+	YYSTYPE value{};
+	YYLTYPE location{};
+	while (yylex(&value, &location, scanner) != 0) {}
+
+	yylex_destroy(scanner);
+}
+
+auto parse(const std::string& source, Arena& arena) -> AstRoot*
+{
+	ParsingContext context{ source, arena };
+	context.get_lexer_util().set_multiline(true);
+
+	if (context.parse() != 0) {
+		throw std::runtime_error("Workload does not parse.");
+	}
+
+	return context.get_root();
+}
+
+
+void print_measurement(std::ostream& json, const std::string_view workload, const std::string_view phase, const Measurement& measurement, bool& is_first)
+{
+	json << (is_first ? "\n" : ",\n");
+	is_first = false;
+
+	json << "    { \"workload\": \"" << workload << "\", \"phase\": \"" << phase << "\""
+		<< ", \"iterations\": " << measurement.iterations
+		<< ", \"ns_per_op\": " << measurement.ns_per_op
+		<< ", \"allocations_per_op\": " << measurement.allocations_per_op
+		<< ", \"bytes_per_op\": " << measurement.bytes_per_op
+		<< " }";
+}
+
+
+auto main(const int argc, const char* argv[]) -> int
+{
+	std::chrono::milliseconds min_time{ 200 };
+	std::string filter;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+
+		if (arg.starts_with("--min-time=")) {
+			min_time = std::chrono::milliseconds{ std::strtoull(argv[i] + 11, nullptr, 10) };
+		}
+		else if (arg.starts_with("--filter=")) {
+			filter = arg.substr(9);
+		}
+		else {
+			std::cerr << "Usage: bench [--min-time=MS] [--filter=WORKLOAD]\n";
+			return 1;
+		}
+	}
+
+	const std::string examples = HOMEWORKSCRIPT_SOURCE_DIR;
+	const std::vector<Workload> workloads{
+		{ "prime_count", read_file(examples + "/examples/prime_count.txt.n") },
+		{ "factorial", read_last_line(examples + "/Examples/factorial.txt") },
+		{ "deep_recursion", make_deep_recursion(2000) },
+		{ "deep_nesting", make_deep_nesting(200) },
+		{ "straight_line", make_straight_line(20000) },
+	};
+
+	// The measured programs print into the void, the report goes to the real standard output.
+	std::ostream json{ std::cout.rdbuf() };
+	NullBuffer null_buffer;
+	std::cout.rdbuf(&null_buffer);
+
+	const ExecutionLimits limits;
+	bool is_first = true;
+
+	json << "{\n  \"benchmarks\": [";
+
+	for (const Workload& workload : workloads)
+	{
+		if (workload.name.find(filter) == std::string::npos) {
+			continue;
+		}
+
+		try {
+			print_measurement(json, workload.name, "lex", measure([&] { lex(workload.source); }, min_time), is_first);
+
+			print_measurement(json, workload.name, "parse", measure([&] {
+				Arena arena;
+				(void)parse(workload.source, arena);
+			}, min_time), is_first);
+
+			Arena arena;
+			AstRoot* root = parse(workload.source, arena);
+			root->fold(arena);
+			root->resolve();
+			(void)root->check_types(arena);
+
+			print_measurement(json, workload.name, "execute_ast", measure([&] { (void)root->run(limits, {}); }, min_time), is_first);
+
+			const BytecodeProgram program = compile_to_bytecode(*root);
+
+			print_measurement(json, workload.name, "execute_bytecode", measure([&] {
+				VirtualMachine machine{ program };
+				(void)machine.run(limits);
+			}, min_time), is_first);
+		}
+		catch (const std::exception& exception) {
+			std::cerr << workload.name << ": " << exception.what() << '\n';
+		}
+	}
+
+	json << "\n  ],\n  \"peak_rss_kb\": " << get_peak_rss_kilobytes() << "\n}\n";
+
+	std::cout.rdbuf(json.rdbuf());
+	return 0;
+}
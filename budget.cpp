@@ -0,0 +1,40 @@
+#include "budget.h"
+
+#include <algorithm>
+
+#include "ast.h"
+
+
+ExecutionBudget::ExecutionBudget(const ExecutionLimits& limits)
+	: remaining_fuel(limits.fuel)
+	, cancellation(limits.cancellation)
+	, max_call_depth(limits.max_call_depth)
+{
+	if (limits.time_limit.has_value()) {
+		deadline = std::chrono::steady_clock::now() + *limits.time_limit;
+	}
+}
+
+void ExecutionBudget::refill()
+{
+	if (cancellation != nullptr && cancellation->load(std::memory_order_relaxed)) {
+		terminate_illegal_program("Execution was cancelled.");
+	}
+
+	if (deadline.has_value() && std::chrono::steady_clock::now() >= *deadline) {
+		terminate_illegal_program("Execution time limit exceeded.");
+	}
+
+	if (remaining_fuel == 0) {
+		terminate_illegal_program("Execution budget exceeded.");
+	}
+
+	const uint64_t batch = std::min<uint64_t>(batch_size, remaining_fuel);
+	remaining_fuel -= batch;
+	countdown = static_cast<uint32_t>(batch);
+}
+
+void ExecutionBudget::fail_call_depth()
+{
+	terminate_illegal_program("Call depth exceeded the limit.");
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+
+/// <summary>
+///	Bounds of a single run, set by the host.
+/// </summary>
+struct ExecutionLimits final
+{
+	static constexpr uint64_t unlimited_fuel = std::numeric_limits<uint64_t>::max();
+	static constexpr uint32_t default_max_call_depth = 1'000'000;
+	static constexpr size_t default_memo_capacity = 4096;
+
+	// Number of loop iterations and function calls the program may perform.
+	uint64_t fuel = unlimited_fuel;
+
+	// Wall-clock time the program may take, measured from the start of the run.
+	std::optional<std::chrono::milliseconds> time_limit;
+
+	// Set by the host (from any thread) to stop the program.
+	const std::atomic<bool>* cancellation = nullptr;
+
+	// Number of calls which may be in progress at once. Tail calls do not count.
+	uint32_t max_call_depth = default_max_call_depth;
+
+	// Number of results of pure function calls kept for reuse. Zero turns memoization off.
+	size_t memo_capacity = default_memo_capacity;
+
+	// Lets the bytecode engine compile hot loops and functions to machine code, where the platform is supported.
+	bool jit = true;
+};
+
+
+// --- Note ---
+// Both engines charge the budget at every loop back-edge and every call, which is
+// where a program can spend unbounded time. Charging only counts down a local
+// counter. The fuel is handed out in small batches, and the clock and the
+// cancellation flag are looked at only when a batch runs out.
+//
+// Calls are also counted while they are in progress, which bounds the memory
+// a runaway recursion may take.
+
+
+class ExecutionBudget final
+{
+	static constexpr uint32_t batch_size = 4096;
+
+	uint32_t countdown = 0;
+	uint64_t remaining_fuel;
+	std::optional<std::chrono::steady_clock::time_point> deadline;
+	const std::atomic<bool>* cancellation;
+	uint32_t call_depth = 0;
+	uint32_t max_call_depth;
+
+	void refill();
+
+	[[noreturn]]
+	static void fail_call_depth();
+
+public:
+	explicit ExecutionBudget(const ExecutionLimits& limits);
+
+	/// <summary>
+	///	Accounts for one loop iteration or call. Terminates the program once any limit is exceeded.
+	/// </summary>
+	void charge()
+	{
+		if (countdown == 0) [[unlikely]] {
+			refill();
+		}
+
+		--countdown;
+	}
+
+	/// <summary>
+	///	Accounts for a call which has not returned yet. Terminates the program once too many are nested.
+	/// </summary>
+	void enter_call()
+	{
+		if (call_depth == max_call_depth) [[unlikely]] {
+			fail_call_depth();
+		}
+
+		++call_depth;
+	}
+
+	void leave_call()
+	{
+		--call_depth;
+	}
+
+	/// <summary>
+	///	Counter of the current batch, for machine code which charges it directly. A batch which has run out is refilled by charge().
+	/// </summary>
+	auto get_countdown() -> uint32_t*
+	{
+		return &countdown;
+	}
+};
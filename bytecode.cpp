@@ -0,0 +1,708 @@
+#include "bytecode.h"
+
+#include <algorithm>
+#include <limits>
+
+
+auto RegisterValue::from_value(const Value& value) -> RegisterValue
+{
+	RegisterValue result;
+
+	if (const Value::Logic* logic = value.try_get<Value::Logic>()) {
+		result.type = RegisterType::Logic;
+		result.payload = *logic ? 1 : 0;
+	}
+	else if (const Value::Number* number = value.try_get<Value::Number>()) {
+		result.type = RegisterType::Number;
+		result.payload = *number;
+	}
+	else {
+		terminate_illegal_program("Text values are not supported by the bytecode engine.");
+	}
+
+	return result;
+}
+
+auto RegisterValue::to_value() const -> Value
+{
+	switch (type) {
+		case RegisterType::Logic:	return Value(payload != 0);
+		case RegisterType::Number:	return Value(payload);
+		default:					terminate_illegal_program("Value is null and can not be evaluated.");
+	}
+}
+
+
+
+BytecodeCompiler::BytecodeCompiler(BytecodeProgram& program, const uint16_t prototype_index)
+	: program(&program)
+	, prototype_index(prototype_index)
+{
+}
+
+auto BytecodeCompiler::prototype() -> FunctionPrototype&
+{
+	return program->prototypes.at(prototype_index);
+}
+
+auto BytecodeCompiler::emit(const OpCode op, const uint16_t a, const uint16_t b, const uint16_t c) -> uint32_t
+{
+	auto& code = prototype().code;
+	code.push_back(Instruction{ op, a, b, c });
+	return static_cast<uint32_t>(code.size() - 1);
+}
+
+auto BytecodeCompiler::emit_jump(const OpCode op, const uint16_t a) -> uint32_t
+{
+	return emit(op, a);
+}
+
+void BytecodeCompiler::patch_jump(const uint32_t jump, const uint32_t target)
+{
+	Instruction& instruction = prototype().code.at(jump);
+	instruction.b = static_cast<uint16_t>(target & 0xFFFF);
+	instruction.c = static_cast<uint16_t>(target >> 16);
+}
+
+auto BytecodeCompiler::current_position() const -> uint32_t
+{
+	return static_cast<uint32_t>(program->prototypes.at(prototype_index).code.size());
+}
+
+auto BytecodeCompiler::get_code() -> std::vector<Instruction>&
+{
+	return prototype().code;
+}
+
+auto BytecodeCompiler::allocate_register() -> uint16_t
+{
+	if (next_register == std::numeric_limits<uint16_t>::max()) {
+		terminate_illegal_program("Function " + prototype().name + " uses too many variables to be compiled.");
+	}
+
+	const uint16_t allocated = next_register++;
+	auto& proto = prototype();
+	proto.register_count = std::max(proto.register_count, next_register);
+	return allocated;
+}
+
+void BytecodeCompiler::release_registers(const uint16_t watermark)
+{
+	next_register = watermark;
+}
+
+auto BytecodeCompiler::get_register_watermark() const -> uint16_t
+{
+	return next_register;
+}
+
+auto BytecodeCompiler::intern_name(const Symbol name) -> uint16_t
+{
+	auto& names = program->names;
+	const auto found = std::find(names.begin(), names.end(), name);
+
+	if (found != names.end()) {
+		return static_cast<uint16_t>(found - names.begin());
+	}
+
+	names.push_back(name);
+	return static_cast<uint16_t>(names.size() - 1);
+}
+
+auto BytecodeCompiler::add_constant(const Value& value) -> uint16_t
+{
+	const RegisterValue constant = RegisterValue::from_value(value);
+	auto& constants = prototype().constants;
+
+	const auto found = std::find_if(
+		constants.begin(),
+		constants.end(),
+		[constant](const RegisterValue& other) -> bool
+		{
+			return other.type == constant.type && other.payload == constant.payload;
+		}
+	);
+
+	if (found != constants.end()) {
+		return static_cast<uint16_t>(found - constants.begin());
+	}
+
+	constants.push_back(constant);
+	return static_cast<uint16_t>(constants.size() - 1);
+}
+
+auto BytecodeCompiler::add_message(std::string message) -> uint16_t
+{
+	program->messages.emplace_back(std::move(message));
+	return static_cast<uint16_t>(program->messages.size() - 1);
+}
+
+auto BytecodeCompiler::add_call_site(const uint16_t argument_count, const bool requires_result) -> uint16_t
+{
+	auto& call_sites = prototype().call_sites;
+	call_sites.push_back(CallSite{ scopes.back().head, argument_count, requires_result });
+	return static_cast<uint16_t>(call_sites.size() - 1);
+}
+
+auto BytecodeCompiler::add_function(
+	const Symbol name,
+	const std::span<const Symbol> signature,
+	const FunctionTraits& traits,
+	const StatementNode& body) -> uint16_t
+{
+	const auto index = static_cast<uint16_t>(program->prototypes.size());
+	program->prototypes.emplace_back();
+	program->prototypes.back().name = symbols().get_name(name);
+	program->prototypes.back().parameter_count = static_cast<uint16_t>(signature.size());
+	program->prototypes.back().is_memoized = traits.is_memoized;
+
+	BytecodeCompiler function_compiler{ *program, index };
+
+	for (const Symbol read : traits.free_reads) {
+		const uint16_t read_index = function_compiler.intern_name(read);
+		function_compiler.prototype().free_reads.push_back(read_index);
+	}
+
+	function_compiler.open_scope();
+
+	for (const Symbol parameter : signature) {
+		const uint16_t slot = function_compiler.allocate_register();
+
+		if (!function_compiler.declare_variable(function_compiler.intern_name(parameter), slot)) {
+			function_compiler.emit(OpCode::Fail, function_compiler.add_message("Value with given name is already declared."));
+		}
+	}
+
+	body.compile_statement(function_compiler);
+	function_compiler.emit(OpCode::ReturnNothing);
+	function_compiler.close_scope();
+
+	return index;
+}
+
+void BytecodeCompiler::open_scope()
+{
+	const uint32_t head = scopes.empty() ? ScopeEntry::none : scopes.back().head;
+	scopes.push_back(LexicalScope{ head, next_register, {}, {} });
+}
+
+void BytecodeCompiler::close_scope()
+{
+	next_register = scopes.back().first_free_register;
+	scopes.pop_back();
+}
+
+auto BytecodeCompiler::find(const uint16_t name, const bool is_function) const -> std::optional<uint16_t>
+{
+	const auto& entries = program->prototypes.at(prototype_index).scope_entries;
+
+	for (uint32_t i = scopes.back().head; i != ScopeEntry::none; i = entries[i].previous) {
+		if (entries[i].name == name && entries[i].is_function == is_function) {
+			return entries[i].slot;
+		}
+	}
+
+	return std::nullopt;
+}
+
+auto BytecodeCompiler::declare(const uint16_t name, const uint16_t slot, const bool is_function) -> bool
+{
+	LexicalScope& scope = scopes.back();
+	auto& declared = is_function ? scope.declared_functions : scope.declared_variables;
+
+	if (std::find(declared.begin(), declared.end(), name) != declared.end()) {
+		return false;
+	}
+
+	declared.push_back(name);
+
+	auto& entries = prototype().scope_entries;
+	entries.push_back(ScopeEntry{ name, slot, is_function, scope.head });
+	scope.head = static_cast<uint32_t>(entries.size() - 1);
+
+	return true;
+}
+
+auto BytecodeCompiler::find_variable(const uint16_t name) const -> std::optional<uint16_t>
+{
+	return find(name, false);
+}
+
+auto BytecodeCompiler::find_function(const uint16_t name) const -> std::optional<uint16_t>
+{
+	return find(name, true);
+}
+
+auto BytecodeCompiler::declare_variable(const uint16_t name, const uint16_t slot) -> bool
+{
+	return declare(name, slot, false);
+}
+
+auto BytecodeCompiler::declare_function(const uint16_t name, const uint16_t prototype) -> bool
+{
+	return declare(name, prototype, true);
+}
+
+auto BytecodeCompiler::is_outermost_scope() const -> bool
+{
+	return scopes.size() == 1;
+}
+
+auto BytecodeCompiler::is_main_prototype() const -> bool
+{
+	return prototype_index == BytecodeProgram::main_prototype;
+}
+
+void BytecodeCompiler::add_global(const uint16_t name, const uint16_t slot)
+{
+	program->globals.push_back(GlobalVariable{ name, slot, current_position() });
+}
+
+
+// A frame is private when nothing may find its declarations by name.
+void mark_private_frames(BytecodeProgram& program)
+{
+	std::vector<uint16_t> dynamic_names;
+
+	for (const FunctionPrototype& prototype : program.prototypes) {
+		for (const Instruction& instruction : prototype.code) {
+			switch (instruction.op) {
+				case OpCode::LoadDynamic:
+				case OpCode::CheckDynamic:
+				case OpCode::StoreDynamic:
+				case OpCode::PrintDynamic:
+					dynamic_names.push_back(instruction.b);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	std::sort(dynamic_names.begin(), dynamic_names.end());
+
+	for (FunctionPrototype& prototype : program.prototypes)
+	{
+		prototype.has_private_frame = std::none_of(
+			prototype.scope_entries.begin(),
+			prototype.scope_entries.end(),
+			[&dynamic_names](const ScopeEntry& entry) -> bool
+			{
+				return entry.is_function || std::binary_search(dynamic_names.begin(), dynamic_names.end(), entry.name);
+			}
+		);
+	}
+}
+
+auto compile_to_bytecode(const AstRoot& root) -> BytecodeProgram
+{
+	BytecodeProgram program;
+	program.prototypes.emplace_back();
+	program.prototypes.back().name = "main";
+
+	BytecodeCompiler compiler{ program, BytecodeProgram::main_prototype };
+	root.compile(compiler);
+
+	mark_private_frames(program);
+
+	return program;
+}
+
+
+
+// Writing the result of the last instruction directly to the variable saves a move.
+auto is_retargetable(const OpCode op) -> bool
+{
+	switch (op) {
+		case OpCode::LoadConstant:
+		case OpCode::Move:
+		case OpCode::LoadDynamic:
+		case OpCode::Add:
+		case OpCode::Subtract:
+		case OpCode::Multiply:
+		case OpCode::Divide:
+		case OpCode::Modulo:
+		case OpCode::And:
+		case OpCode::Or:
+		case OpCode::Xor:
+		case OpCode::Equal:
+		case OpCode::NotEqual:
+		case OpCode::Less:
+		case OpCode::LessOrEqual:
+		case OpCode::More:
+		case OpCode::MoreOrEqual:
+		case OpCode::Not:
+		case OpCode::Negate:
+			return true;
+		default:
+			return false;
+	}
+}
+
+struct BinaryOpCodeSelector final
+{
+	OpCode* target;
+
+	void operator()(const ArithmeticOperation operation) const
+	{
+		switch (operation) {
+			case ArithmeticOperation::Addition:			*target = OpCode::Add; break;
+			case ArithmeticOperation::Substraction:		*target = OpCode::Subtract; break;
+			case ArithmeticOperation::Multiplication:	*target = OpCode::Multiply; break;
+			case ArithmeticOperation::Division:			*target = OpCode::Divide; break;
+			case ArithmeticOperation::Modulo:			*target = OpCode::Modulo; break;
+		}
+	}
+
+	void operator()(const LogicOperation operation) const
+	{
+		switch (operation) {
+			case LogicOperation::And:	*target = OpCode::And; break;
+			case LogicOperation::Or:	*target = OpCode::Or; break;
+			case LogicOperation::Xor:	*target = OpCode::Xor; break;
+		}
+	}
+
+	void operator()(const ComparisonOperation operation) const
+	{
+		switch (operation) {
+			case ComparisonOperation::Equality:		*target = OpCode::Equal; break;
+			case ComparisonOperation::Inequality:	*target = OpCode::NotEqual; break;
+			case ComparisonOperation::Less:			*target = OpCode::Less; break;
+			case ComparisonOperation::LessOrEqual:	*target = OpCode::LessOrEqual; break;
+			case ComparisonOperation::More:			*target = OpCode::More; break;
+			case ComparisonOperation::MoreOrEqual:	*target = OpCode::MoreOrEqual; break;
+		}
+	}
+};
+
+
+void AstRoot::compile(BytecodeCompiler& compiler) const
+{
+	compiler.open_scope();
+	this->head_statement->compile_statement(compiler);
+	compiler.emit(OpCode::ReturnNothing);
+	compiler.close_scope();
+}
+
+
+auto BraceExpressionNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	return this->braced_expression->compile_expression(compiler);
+}
+
+auto LiteralNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	const uint16_t target = compiler.allocate_register();
+	compiler.emit(OpCode::LoadConstant, target, compiler.add_constant(this->value));
+	return target;
+}
+
+auto UnaryOperationNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+	const uint16_t operand = this->child->compile_expression(compiler);
+
+	compiler.release_registers(watermark);
+	const uint16_t target = compiler.allocate_register();
+
+	switch (operator_) {
+		case UnaryOperation::Not:		compiler.emit(OpCode::Not, target, operand); break;
+		case UnaryOperation::Negate:	compiler.emit(OpCode::Negate, target, operand); break;
+	}
+
+	return target;
+}
+
+auto BinaryOperationNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+	uint16_t left = this->left_child->compile_expression(compiler);
+
+	// A called function may reassign the variable, the tree walker would see its value from before the call.
+	if (left < watermark && this->right_child->contains_call()) {
+		const uint16_t copy = compiler.allocate_register();
+		compiler.emit(OpCode::Move, copy, left);
+		left = copy;
+	}
+
+	const uint16_t right = this->right_child->compile_expression(compiler);
+
+	OpCode op{};
+	std::visit(BinaryOpCodeSelector{ &op }, this->operation_);
+
+	compiler.release_registers(watermark);
+	const uint16_t target = compiler.allocate_register();
+	compiler.emit(op, target, left, right);
+
+	return target;
+}
+
+auto TypedUnaryOperationNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+	const uint16_t operand = this->child->compile_expression(compiler);
+
+	compiler.release_registers(watermark);
+	const uint16_t target = compiler.allocate_register();
+	compiler.emit(operation == UnaryOperation::Not ? OpCode::Not : OpCode::Negate, target, operand);
+
+	return target;
+}
+
+auto TypedBinaryOperationNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+	uint16_t left = this->left_child->compile_expression(compiler);
+
+	if (left < watermark && this->right_child->contains_call()) {
+		const uint16_t copy = compiler.allocate_register();
+		compiler.emit(OpCode::Move, copy, left);
+		left = copy;
+	}
+
+	const uint16_t right = this->right_child->compile_expression(compiler);
+
+	// The VM checks the types of registers anyway, the typed operations share its opcodes.
+	OpCode op{};
+	switch (this->operation) {
+		case TypedOperation::NumberAddition:		op = OpCode::Add; break;
+		case TypedOperation::NumberSubstraction:	op = OpCode::Subtract; break;
+		case TypedOperation::NumberMultiplication:	op = OpCode::Multiply; break;
+		case TypedOperation::NumberDivision:		op = OpCode::Divide; break;
+		case TypedOperation::NumberModulo:			op = OpCode::Modulo; break;
+		case TypedOperation::NumberEquality:		op = OpCode::Equal; break;
+		case TypedOperation::NumberInequality:		op = OpCode::NotEqual; break;
+		case TypedOperation::NumberLess:			op = OpCode::Less; break;
+		case TypedOperation::NumberLessOrEqual:		op = OpCode::LessOrEqual; break;
+		case TypedOperation::NumberMore:			op = OpCode::More; break;
+		case TypedOperation::NumberMoreOrEqual:		op = OpCode::MoreOrEqual; break;
+		case TypedOperation::LogicAnd:				op = OpCode::And; break;
+		case TypedOperation::LogicOr:				op = OpCode::Or; break;
+		case TypedOperation::LogicXor:				op = OpCode::Xor; break;
+		case TypedOperation::LogicEquality:			op = OpCode::Equal; break;
+		case TypedOperation::LogicInequality:		op = OpCode::NotEqual; break;
+	}
+
+	compiler.release_registers(watermark);
+	const uint16_t target = compiler.allocate_register();
+	compiler.emit(op, target, left, right);
+
+	return target;
+}
+
+auto VariableReferenceNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	const uint16_t name_index = compiler.intern_name(this->name);
+
+	if (const auto slot = compiler.find_variable(name_index)) {
+		return *slot;
+	}
+
+	const uint16_t target = compiler.allocate_register();
+	compiler.emit(OpCode::LoadDynamic, target, name_index, compiler.add_message("Value is null and can not be evaluated."));
+	return target;
+}
+
+
+void BlockNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	for (const StatementNode* statement : this->statements) {
+		statement->compile_statement(compiler);
+	}
+}
+
+void BodyNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	this->body_statement->compile_statement(compiler);
+}
+
+void ResultNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	if (const FunctionCallNode* call = this->result_expression->try_get_call(); call != nullptr && !compiler.is_main_prototype()) {
+		call->compile_tail_call(compiler);
+		return;
+	}
+
+	const uint16_t watermark = compiler.get_register_watermark();
+	const uint16_t result = this->result_expression->compile_expression(compiler);
+	compiler.emit(OpCode::Return, result);
+	compiler.release_registers(watermark);
+}
+
+void VariableAssignmentNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	const uint16_t name_index = compiler.intern_name(this->variable_name);
+
+	if (this->is_reassignment)
+	{
+		const uint16_t watermark = compiler.get_register_watermark();
+
+		if (const auto slot = compiler.find_variable(name_index)) {
+			const uint16_t value = this->expression->compile_expression(compiler);
+			compiler.emit(OpCode::Reassign, *slot, value);
+		}
+		else {
+			compiler.emit(OpCode::CheckDynamic, 0, name_index, compiler.add_message("The value " + std::string(symbols().get_name(variable_name)) + "does not exist!"));
+			const uint16_t value = this->expression->compile_expression(compiler);
+			compiler.emit(OpCode::StoreDynamic, value, name_index);
+		}
+
+		compiler.release_registers(watermark);
+	}
+	else // New Variable
+	{
+		const uint16_t slot = compiler.allocate_register();
+		const uint16_t watermark = compiler.get_register_watermark();
+		const uint32_t position = compiler.current_position();
+		const uint16_t value = this->expression->compile_expression(compiler);
+
+		if (value != slot) {
+			auto& code = compiler.get_code();
+
+			if (value >= watermark && code.size() > position && code.back().a == value && is_retargetable(code.back().op)) {
+				code.back().a = slot;
+			} else {
+				compiler.emit(OpCode::Move, slot, value);
+			}
+		}
+
+		compiler.release_registers(watermark);
+
+		if (!compiler.declare_variable(name_index, slot)) {
+			compiler.emit(OpCode::Fail, compiler.add_message("Value with given name is already declared."));
+		}
+		else if (compiler.is_main_prototype() && compiler.is_outermost_scope()) {
+			compiler.add_global(name_index, slot);
+		}
+	}
+}
+
+void ConditionalStatementNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+
+	const uint32_t loop_start = compiler.current_position();
+
+	const uint16_t condition_watermark = compiler.get_register_watermark();
+	const uint16_t condition_value = this->condition->compile_expression(compiler);
+	const uint32_t exit_jump = compiler.emit_jump(OpCode::JumpIfFalse, condition_value);
+	compiler.release_registers(condition_watermark);
+
+	compiler.open_scope();
+	this->statement->compile_statement(compiler);
+	compiler.close_scope();
+
+	if (this->repeating) {
+		const uint32_t back_jump = compiler.emit_jump(OpCode::Loop, 0);
+		compiler.patch_jump(back_jump, loop_start);
+	}
+
+	compiler.patch_jump(exit_jump, compiler.current_position());
+	compiler.release_registers(watermark);
+}
+
+void IncrementNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	const uint16_t name_index = compiler.intern_name(this->variable_name);
+	const uint16_t watermark = compiler.get_register_watermark();
+
+	if (const auto slot = compiler.find_variable(name_index)) {
+		const uint16_t amount = compiler.allocate_register();
+		compiler.emit(OpCode::LoadConstant, amount, compiler.add_constant(Value(this->amount)));
+		compiler.emit(OpCode::Add, *slot, *slot, amount);
+	}
+	else {
+		compiler.emit(OpCode::CheckDynamic, 0, name_index, compiler.add_message("The value " + std::string(symbols().get_name(variable_name)) + "does not exist!"));
+
+		const uint16_t value = compiler.allocate_register();
+		compiler.emit(OpCode::LoadDynamic, value, name_index, compiler.add_message("Value is null and can not be evaluated."));
+
+		const uint16_t amount = compiler.allocate_register();
+		compiler.emit(OpCode::LoadConstant, amount, compiler.add_constant(Value(this->amount)));
+		compiler.emit(OpCode::Add, value, value, amount);
+		compiler.emit(OpCode::StoreDynamic, value, name_index);
+	}
+
+	compiler.release_registers(watermark);
+}
+
+void ComparisonLoopNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	this->loop->compile_statement(compiler);
+}
+
+void FunctionDeclarationNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	const uint16_t prototype = compiler.add_function(this->name, this->args->get_list(), this->traits, *this->body);
+
+	if (!compiler.declare_function(compiler.intern_name(this->name), prototype)) {
+		compiler.emit(OpCode::Fail, compiler.add_message("Function with given name is already declared."));
+	}
+}
+
+auto FunctionCallNode::compile_call(BytecodeCompiler& compiler, const bool requires_result, const bool is_tail_call) const -> uint16_t
+{
+	const std::span<const Symbol> arg_names = this->args->get_list();
+	const uint16_t base = compiler.get_register_watermark();
+
+	for (const Symbol arg : arg_names) {
+		const uint16_t target = compiler.allocate_register();
+		const uint16_t arg_index = compiler.intern_name(arg);
+
+		if (const auto slot = compiler.find_variable(arg_index)) {
+			compiler.emit(OpCode::Move, target, *slot);
+		} else {
+			compiler.emit(OpCode::LoadDynamic, target, arg_index, compiler.add_message("Function argument " + std::string(symbols().get_name(arg)) + " does not exist."));
+		}
+	}
+
+	if (arg_names.empty()) {
+		compiler.allocate_register();
+	}
+
+	const uint16_t call_site = compiler.add_call_site(static_cast<uint16_t>(arg_names.size()), requires_result);
+	const uint16_t name_index = compiler.intern_name(this->name);
+
+	if (const auto prototype = compiler.find_function(name_index)) {
+		compiler.emit(is_tail_call ? OpCode::TailCall : OpCode::Call, base, *prototype, call_site);
+	} else {
+		compiler.emit(is_tail_call ? OpCode::TailCallDynamic : OpCode::CallDynamic, base, name_index, call_site);
+	}
+
+	// Only the result is kept alive.
+	compiler.release_registers(base + 1);
+
+	return base;
+}
+
+auto FunctionCallNode::compile_expression(BytecodeCompiler& compiler) const -> uint16_t
+{
+	return compile_call(compiler, true, false);
+}
+
+void FunctionCallNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+	compile_call(compiler, false, false);
+	compiler.release_registers(watermark);
+}
+
+void FunctionCallNode::compile_tail_call(BytecodeCompiler& compiler) const
+{
+	const uint16_t watermark = compiler.get_register_watermark();
+	const uint16_t result = compile_call(compiler, true, true);
+	compiler.emit(OpCode::Return, result);
+	compiler.release_registers(watermark);
+}
+
+void PrintNode::compile_statement(BytecodeCompiler& compiler) const
+{
+	const uint16_t name_index = compiler.intern_name(this->name);
+
+	if (const auto slot = compiler.find_variable(name_index)) {
+		compiler.emit(OpCode::Print, *slot, name_index);
+	} else {
+		compiler.emit(OpCode::PrintDynamic, 0, name_index);
+	}
+}
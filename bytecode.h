@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+
+
+// --- Note ---
+// The bytecode engine is an alternative to the tree walker. The AST is compiled
+// to a register machine: every function gets a prototype with a fixed register window.
+// Variables declared in the function are bound to registers at compile time,
+// so the common path does not look anything up by name.
+//
+// The language is dynamically scoped: a function body runs with its caller's scope
+// as parent. Names which are not declared in the function itself are therefore
+// resolved at runtime. Each call site remembers which declarations were visible
+// at that point (a chain of scope entries), and the VM walks the chain of suspended
+// callers when a free name is referenced.
+//
+// Frames live on the heap, so the depth of recursion is bounded only by the limits of
+// the run. A tail call replaces the frame of the caller when the frame is private:
+// none of its declarations is ever looked up by name.
+
+
+enum class OpCode : uint8_t
+{
+	LoadConstant,		// R[A] = K[B]
+	Move,				// R[A] = R[B]
+	Reassign,			// R[A] = R[B], the type of R[A] must not change
+
+	LoadDynamic,		// R[A] = lookup(N[B]), C = missing name message
+	CheckDynamic,		// lookup(N[B]) must exist, C = missing name message
+	StoreDynamic,		// lookup(N[B]) = R[A], the type must not change
+
+	Add,				// R[A] = R[B] op R[C]
+	Subtract,
+	Multiply,
+	Divide,
+	Modulo,
+
+	And,
+	Or,
+	Xor,
+
+	Equal,
+	NotEqual,
+	Less,
+	LessOrEqual,
+	More,
+	MoreOrEqual,
+
+	Not,				// R[A] = op R[B]
+	Negate,
+
+	Jump,				// pc = BC
+	JumpIfFalse,		// if !R[A] then pc = BC, R[A] must be logic
+	Loop,				// pc = BC, charges the execution budget
+
+	Call,				// R[A] = call P[B](R[A] ... R[A + argc - 1]), C = call site
+	CallDynamic,		// R[A] = call lookup(N[B])(R[A] ...), C = call site
+	TailCall,			// as Call, replaces a private frame, always followed by Return R[A]
+	TailCallDynamic,	// as CallDynamic, replaces a private frame, always followed by Return R[A]
+	Return,				// return R[A]
+	ReturnNothing,
+
+	Print,				// print R[A] as N[B]
+	PrintDynamic,		// print lookup(N[B])
+
+	Fail,				// terminate with message M[A]
+};
+
+struct Instruction final
+{
+	OpCode op;
+	uint16_t a = 0;
+	uint16_t b = 0;
+	uint16_t c = 0;
+
+	[[nodiscard]]
+	auto target() const -> uint32_t
+	{
+		return static_cast<uint32_t>(b) | (static_cast<uint32_t>(c) << 16);
+	}
+};
+
+
+enum class RegisterType : uint8_t
+{
+	Undefined,
+	Logic,
+	Number,
+};
+
+struct RegisterValue final
+{
+	RegisterType type = RegisterType::Undefined;
+	int32_t payload = 0;
+
+	[[nodiscard]]
+	static auto from_value(const Value& value) -> RegisterValue;
+
+	[[nodiscard]]
+	auto to_value() const -> Value;
+};
+
+
+// Declaration visible at some point of a function. Entries form chains through `previous`,
+// a call site stores the head of the chain valid at the moment of the call.
+struct ScopeEntry final
+{
+	static constexpr uint32_t none = UINT32_MAX;
+
+	uint16_t name;
+	uint16_t slot;			// Register for variables, prototype for functions.
+	bool is_function;
+	uint32_t previous = none;
+};
+
+struct CallSite final
+{
+	uint32_t scope_head = ScopeEntry::none;
+	uint16_t argument_count = 0;
+	bool requires_result = false;
+};
+
+struct FunctionPrototype final
+{
+	std::string name;
+	uint16_t parameter_count = 0;
+	uint16_t register_count = 0;
+	bool has_private_frame = false;
+	bool is_memoized = false;
+	std::vector<uint16_t> free_reads;	// Names whose values are inputs of a memoized function.
+
+	std::vector<Instruction> code;
+	std::vector<RegisterValue> constants;
+	std::vector<ScopeEntry> scope_entries;
+	std::vector<CallSite> call_sites;
+};
+
+struct GlobalVariable final
+{
+	uint16_t name;
+	uint16_t slot;
+	uint32_t declared_at;	// Position of the first instruction after the declaration.
+};
+
+struct BytecodeProgram final
+{
+	static constexpr uint16_t main_prototype = 0;
+
+	std::vector<FunctionPrototype> prototypes;
+	std::vector<Symbol> names;
+	std::vector<std::string> messages;
+
+	// Variables of the outermost scope, in the order of declaration.
+	std::vector<GlobalVariable> globals;
+};
+
+
+class BytecodeCompiler final
+{
+	struct LexicalScope final
+	{
+		uint32_t head;
+		uint16_t first_free_register;
+		std::vector<uint16_t> declared_variables;
+		std::vector<uint16_t> declared_functions;
+	};
+
+	BytecodeProgram* program;
+	uint16_t prototype_index;
+	std::vector<LexicalScope> scopes;
+	uint16_t next_register = 0;
+
+
+	auto prototype() -> FunctionPrototype&;
+
+	auto find(uint16_t name, bool is_function) const -> std::optional<uint16_t>;
+
+	auto declare(uint16_t name, uint16_t slot, bool is_function) -> bool;
+
+public:
+	explicit BytecodeCompiler(BytecodeProgram& program, uint16_t prototype_index);
+
+
+	auto emit(OpCode op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0) -> uint32_t;
+
+	auto emit_jump(OpCode op, uint16_t a = 0) -> uint32_t;
+
+	void patch_jump(uint32_t jump, uint32_t target);
+
+	[[nodiscard]]
+	auto current_position() const -> uint32_t;
+
+	auto get_code() -> std::vector<Instruction>&;
+
+
+	auto allocate_register() -> uint16_t;
+
+	/// <summary>
+	///	Releases temporaries allocated after the given watermark.
+	/// </summary>
+	void release_registers(uint16_t watermark);
+
+	[[nodiscard]]
+	auto get_register_watermark() const -> uint16_t;
+
+
+	auto intern_name(Symbol name) -> uint16_t;
+
+	auto add_constant(const Value& value) -> uint16_t;
+
+	auto add_message(std::string message) -> uint16_t;
+
+	auto add_call_site(uint16_t argument_count, bool requires_result) -> uint16_t;
+
+	/// <summary>
+	///	Compiles a nested function to its own prototype and returns its index.
+	/// </summary>
+	auto add_function(Symbol name, std::span<const Symbol> signature, const FunctionTraits& traits, const StatementNode& body) -> uint16_t;
+
+
+	void open_scope();
+
+	void close_scope();
+
+	[[nodiscard]]
+	auto find_variable(uint16_t name) const -> std::optional<uint16_t>;
+
+	[[nodiscard]]
+	auto find_function(uint16_t name) const -> std::optional<uint16_t>;
+
+	/// <summary>
+	///	Binds the variable to the register in the innermost scope. Returns false when already declared.
+	/// </summary>
+	auto declare_variable(uint16_t name, uint16_t slot) -> bool;
+
+	auto declare_function(uint16_t name, uint16_t prototype) -> bool;
+
+	[[nodiscard]]
+	auto is_outermost_scope() const -> bool;
+
+	[[nodiscard]]
+	auto is_main_prototype() const -> bool;
+
+	void add_global(uint16_t name, uint16_t slot);
+};
+
+
+// Version of the programs compile_to_bytecode produces. Compiled programs are cached
+// on disk, so it must be bumped whenever the front end starts accepting different
+// programs, or compiles any of them differently.
+//  1 - first cached format
+//  2 - programs are type checked before compiling, fused increments and loops
+//  3 - cache files also record the length and a second hash of the source
+constexpr uint32_t bytecode_version = 3;
+
+/// <summary>
+///	Compiles the whole program starting from its root.
+/// </summary>
+auto compile_to_bytecode(const AstRoot& root) -> BytecodeProgram;
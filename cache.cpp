@@ -0,0 +1,647 @@
+#include "cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+	#include <iterator>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "symbols.h"
+#include "vm.h"
+
+
+namespace CacheFormat
+{
+	constexpr uint32_t magic = 0x43425348;	// "HSBC"
+	constexpr uint32_t version = bytecode_version;
+
+	struct Header final
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t source_hash;
+		uint64_t source_size;
+		uint64_t source_digest;
+		uint64_t payload_size;
+		uint64_t payload_checksum;
+	};
+
+
+	// Second hash of the source, unrelated to FNV-1a, so that sources colliding in the file name
+	// and the source hash are still told apart. Words are mixed as in MurmurHash64A.
+	auto digest(const std::string_view source) -> uint64_t
+	{
+		constexpr uint64_t multiplier = 0xC6A4A7935BD1E995ull;
+		uint64_t hash = 0x9E3779B97F4A7C15ull ^ (source.size() * multiplier);
+
+		const auto mix = [&hash](uint64_t word)
+		{
+			word *= multiplier;
+			word ^= word >> 47;
+			word *= multiplier;
+			hash ^= word;
+			hash *= multiplier;
+		};
+
+		size_t position = 0;
+
+		for (; source.size() - position >= sizeof(uint64_t); position += sizeof(uint64_t))
+		{
+			uint64_t word;
+			std::memcpy(&word, source.data() + position, sizeof(uint64_t));
+			mix(word);
+		}
+
+		if (position < source.size()) {
+			uint64_t tail = 0;
+			std::memcpy(&tail, source.data() + position, source.size() - position);
+			mix(tail);
+		}
+
+		hash ^= hash >> 47;
+		hash *= multiplier;
+		hash ^= hash >> 47;
+		return hash;
+	}
+
+
+	class Writer final
+	{
+		std::string buffer;
+
+	public:
+		template<typename T>
+		void put(const T value)
+		{
+			static_assert(std::is_integral_v<T>, "Only integers are written directly.");
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void put_string(const std::string_view text)
+		{
+			put(static_cast<uint32_t>(text.size()));
+			buffer.append(text);
+		}
+
+		[[nodiscard]]
+		auto get_buffer() const -> const std::string&
+		{
+			return buffer;
+		}
+	};
+
+
+	// Reads the payload without ever leaving it. A read past the end marks the reader as failed
+	// and yields zeros, so the caller checks the outcome once, at the end.
+	class Reader final
+	{
+		std::span<const std::byte> data;
+		size_t position = 0;
+		bool failed = false;
+
+	public:
+		explicit Reader(const std::span<const std::byte> data)
+			: data(data)
+		{
+		}
+
+		template<typename T>
+		auto get() -> T
+		{
+			static_assert(std::is_integral_v<T>, "Only integers are read directly.");
+			T value{};
+
+			if (failed || data.size() - position < sizeof(T)) {
+				failed = true;
+				return value;
+			}
+
+			std::memcpy(&value, data.data() + position, sizeof(T));
+			position += sizeof(T);
+			return value;
+		}
+
+		auto get_string() -> std::string_view
+		{
+			const uint32_t size = get<uint32_t>();
+
+			if (failed || data.size() - position < size) {
+				failed = true;
+				return {};
+			}
+
+			const std::string_view text{ reinterpret_cast<const char*>(data.data() + position), size };
+			position += size;
+			return text;
+		}
+
+		/// <summary>
+		///	Reads the length of an array whose elements take at least the given number of bytes each.
+		/// </summary>
+		auto get_count(const size_t minimal_element_size) -> uint32_t
+		{
+			const uint32_t count = get<uint32_t>();
+
+			if (failed || (data.size() - position) / minimal_element_size < count) {
+				failed = true;
+				return 0;
+			}
+
+			return count;
+		}
+
+		[[nodiscard]]
+		auto is_complete() const -> bool
+		{
+			return !failed && position == data.size();
+		}
+	};
+
+
+	auto checksum(const std::span<const std::byte> payload) -> uint64_t
+	{
+		return hash_source(std::string_view{ reinterpret_cast<const char*>(payload.data()), payload.size() });
+	}
+
+
+	void write_program(Writer& writer, const BytecodeProgram& program)
+	{
+		writer.put(static_cast<uint32_t>(program.names.size()));
+		for (const Symbol name : program.names) {
+			writer.put_string(symbols().get_name(name));
+		}
+
+		writer.put(static_cast<uint32_t>(program.messages.size()));
+		for (const std::string& message : program.messages) {
+			writer.put_string(message);
+		}
+
+		writer.put(static_cast<uint32_t>(program.globals.size()));
+		for (const GlobalVariable& global : program.globals) {
+			writer.put(global.name);
+			writer.put(global.slot);
+			writer.put(global.declared_at);
+		}
+
+		writer.put(static_cast<uint32_t>(program.prototypes.size()));
+		for (const FunctionPrototype& prototype : program.prototypes)
+		{
+			writer.put_string(prototype.name);
+			writer.put(prototype.parameter_count);
+			writer.put(prototype.register_count);
+			writer.put(static_cast<uint8_t>(prototype.has_private_frame));
+			writer.put(static_cast<uint8_t>(prototype.is_memoized));
+
+			writer.put(static_cast<uint32_t>(prototype.free_reads.size()));
+			for (const uint16_t name : prototype.free_reads) {
+				writer.put(name);
+			}
+
+			writer.put(static_cast<uint32_t>(prototype.code.size()));
+			for (const Instruction& instruction : prototype.code) {
+				writer.put(static_cast<uint8_t>(instruction.op));
+				writer.put(instruction.a);
+				writer.put(instruction.b);
+				writer.put(instruction.c);
+			}
+
+			writer.put(static_cast<uint32_t>(prototype.constants.size()));
+			for (const RegisterValue& constant : prototype.constants) {
+				writer.put(static_cast<uint8_t>(constant.type));
+				writer.put(constant.payload);
+			}
+
+			writer.put(static_cast<uint32_t>(prototype.scope_entries.size()));
+			for (const ScopeEntry& entry : prototype.scope_entries) {
+				writer.put(entry.name);
+				writer.put(entry.slot);
+				writer.put(static_cast<uint8_t>(entry.is_function));
+				writer.put(entry.previous);
+			}
+
+			writer.put(static_cast<uint32_t>(prototype.call_sites.size()));
+			for (const CallSite& site : prototype.call_sites) {
+				writer.put(site.scope_head);
+				writer.put(site.argument_count);
+				writer.put(static_cast<uint8_t>(site.requires_result));
+			}
+		}
+	}
+
+	// --- Note ---
+	// The checksum only tells that the file was written whole, not by whom. The VM and the
+	// machine code of the JIT index registers, constants and tables without checking them,
+	// so every index of a loaded program is checked against the sizes decoded with it,
+	// exactly as the instructions use them. A program which fails any check is not loaded.
+
+	auto is_valid_instruction(const BytecodeProgram& program, const FunctionPrototype& prototype, const Instruction& instruction) -> bool
+	{
+		const auto is_register = [&prototype](const uint32_t index) { return index < prototype.register_count; };
+		const auto is_name = [&program](const uint32_t index) { return index < program.names.size(); };
+		const auto is_message = [&program](const uint32_t index) { return index < program.messages.size(); };
+		const auto is_target = [&prototype](const uint32_t index) { return index < prototype.code.size(); };
+
+		// Arguments occupy the registers from A onwards, the result lands in A.
+		const auto is_call = [&](const uint32_t site) {
+			return site < prototype.call_sites.size()
+				&& is_register(instruction.a)
+				&& instruction.a + prototype.call_sites[site].argument_count <= prototype.register_count;
+		};
+
+		switch (instruction.op)
+		{
+			case OpCode::LoadConstant:
+				return is_register(instruction.a) && instruction.b < prototype.constants.size();
+
+			case OpCode::Move:
+			case OpCode::Reassign:
+			case OpCode::Not:
+			case OpCode::Negate:
+				return is_register(instruction.a) && is_register(instruction.b);
+
+			case OpCode::LoadDynamic:
+				return is_register(instruction.a) && is_name(instruction.b) && is_message(instruction.c);
+
+			case OpCode::CheckDynamic:
+				return is_name(instruction.b) && is_message(instruction.c);
+
+			case OpCode::StoreDynamic:
+			case OpCode::Print:
+				return is_register(instruction.a) && is_name(instruction.b);
+
+			case OpCode::Add:
+			case OpCode::Subtract:
+			case OpCode::Multiply:
+			case OpCode::Divide:
+			case OpCode::Modulo:
+			case OpCode::And:
+			case OpCode::Or:
+			case OpCode::Xor:
+			case OpCode::Equal:
+			case OpCode::NotEqual:
+			case OpCode::Less:
+			case OpCode::LessOrEqual:
+			case OpCode::More:
+			case OpCode::MoreOrEqual:
+				return is_register(instruction.a) && is_register(instruction.b) && is_register(instruction.c);
+
+			case OpCode::Jump:
+			case OpCode::Loop:
+				return is_target(instruction.target());
+
+			case OpCode::JumpIfFalse:
+				return is_register(instruction.a) && is_target(instruction.target());
+
+			case OpCode::Call:
+			case OpCode::TailCall:
+				return instruction.b < program.prototypes.size() && is_call(instruction.c);
+
+			case OpCode::CallDynamic:
+			case OpCode::TailCallDynamic:
+				return is_name(instruction.b) && is_call(instruction.c);
+
+			case OpCode::Return:
+				return is_register(instruction.a);
+
+			case OpCode::ReturnNothing:
+				return true;
+
+			case OpCode::PrintDynamic:
+				return is_name(instruction.b);
+
+			case OpCode::Fail:
+				return is_message(instruction.a);
+		}
+
+		return false;
+	}
+
+	auto is_valid_prototype(const BytecodeProgram& program, const FunctionPrototype& prototype) -> bool
+	{
+		if (prototype.parameter_count > prototype.register_count || prototype.code.empty()) {
+			return false;
+		}
+
+		// Execution must never run past the last instruction.
+		switch (prototype.code.back().op) {
+			case OpCode::Jump:
+			case OpCode::Loop:
+			case OpCode::Return:
+			case OpCode::ReturnNothing:
+			case OpCode::Fail:
+				break;
+			default:
+				return false;
+		}
+
+		for (const Instruction& instruction : prototype.code) {
+			if (!is_valid_instruction(program, prototype, instruction)) {
+				return false;
+			}
+		}
+
+		for (const uint16_t name : prototype.free_reads) {
+			if (name >= program.names.size()) {
+				return false;
+			}
+		}
+
+		for (uint32_t i = 0; i < prototype.scope_entries.size(); ++i)
+		{
+			const ScopeEntry& entry = prototype.scope_entries[i];
+			const size_t slot_limit = entry.is_function ? program.prototypes.size() : prototype.register_count;
+
+			// Chains only lead to earlier entries, so every walk ends.
+			if (entry.name >= program.names.size()
+				|| entry.slot >= slot_limit
+				|| (entry.previous != ScopeEntry::none && entry.previous >= i))
+			{
+				return false;
+			}
+		}
+
+		for (const CallSite& site : prototype.call_sites) {
+			if (site.scope_head != ScopeEntry::none && site.scope_head >= prototype.scope_entries.size()) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	auto is_valid_program(const BytecodeProgram& program) -> bool
+	{
+		if (program.prototypes.empty() || program.names.size() >= LookupCache::empty) {
+			return false;
+		}
+
+		const FunctionPrototype& main = program.prototypes[BytecodeProgram::main_prototype];
+
+		for (const GlobalVariable& global : program.globals) {
+			if (global.name >= program.names.size() || global.slot >= main.register_count) {
+				return false;
+			}
+		}
+
+		return std::all_of(program.prototypes.begin(), program.prototypes.end(), [&program](const FunctionPrototype& prototype) {
+			return is_valid_prototype(program, prototype);
+		});
+	}
+
+
+	auto read_program(Reader& reader) -> std::optional<BytecodeProgram>
+	{
+		BytecodeProgram program;
+
+		program.names.resize(reader.get_count(sizeof(uint32_t)));
+		for (Symbol& name : program.names) {
+			name = symbols().intern(reader.get_string());
+		}
+
+		program.messages.resize(reader.get_count(sizeof(uint32_t)));
+		for (std::string& message : program.messages) {
+			message = reader.get_string();
+		}
+
+		program.globals.resize(reader.get_count(8));
+		for (GlobalVariable& global : program.globals) {
+			global.name = reader.get<uint16_t>();
+			global.slot = reader.get<uint16_t>();
+			global.declared_at = reader.get<uint32_t>();
+		}
+
+		program.prototypes.resize(reader.get_count(26));
+		for (FunctionPrototype& prototype : program.prototypes)
+		{
+			prototype.name = reader.get_string();
+			prototype.parameter_count = reader.get<uint16_t>();
+			prototype.register_count = reader.get<uint16_t>();
+			prototype.has_private_frame = reader.get<uint8_t>() != 0;
+			prototype.is_memoized = reader.get<uint8_t>() != 0;
+
+			prototype.free_reads.resize(reader.get_count(2));
+			for (uint16_t& name : prototype.free_reads) {
+				name = reader.get<uint16_t>();
+			}
+
+			prototype.code.resize(reader.get_count(7));
+			for (Instruction& instruction : prototype.code) {
+				instruction.op = static_cast<OpCode>(reader.get<uint8_t>());
+				instruction.a = reader.get<uint16_t>();
+				instruction.b = reader.get<uint16_t>();
+				instruction.c = reader.get<uint16_t>();
+
+				if (instruction.op > OpCode::Fail) {
+					return std::nullopt;
+				}
+			}
+
+			prototype.constants.resize(reader.get_count(5));
+			for (RegisterValue& constant : prototype.constants) {
+				constant.type = static_cast<RegisterType>(reader.get<uint8_t>());
+				constant.payload = reader.get<int32_t>();
+
+				if (constant.type > RegisterType::Number) {
+					return std::nullopt;
+				}
+			}
+
+			prototype.scope_entries.resize(reader.get_count(9));
+			for (ScopeEntry& entry : prototype.scope_entries) {
+				entry.name = reader.get<uint16_t>();
+				entry.slot = reader.get<uint16_t>();
+				entry.is_function = reader.get<uint8_t>() != 0;
+				entry.previous = reader.get<uint32_t>();
+			}
+
+			prototype.call_sites.resize(reader.get_count(7));
+			for (CallSite& site : prototype.call_sites) {
+				site.scope_head = reader.get<uint32_t>();
+				site.argument_count = reader.get<uint16_t>();
+				site.requires_result = reader.get<uint8_t>() != 0;
+			}
+		}
+
+		if (!reader.is_complete() || !is_valid_program(program)) {
+			return std::nullopt;
+		}
+
+		return program;
+	}
+
+
+	// Read-only view of a whole file, mapped into memory where the platform allows it.
+	class MappedFile final
+	{
+#ifdef _WIN32
+		std::vector<std::byte> contents;
+#else
+		void* address = nullptr;
+		size_t size = 0;
+#endif
+
+	public:
+		explicit MappedFile(const std::filesystem::path& path)
+		{
+#ifdef _WIN32
+			std::ifstream file{ path, std::ios::binary };
+
+			if (file) {
+				const std::vector<char> bytes{ std::istreambuf_iterator<char>{ file }, {} };
+				contents.resize(bytes.size());
+				std::memcpy(contents.data(), bytes.data(), bytes.size());
+			}
+#else
+			const int descriptor = ::open(path.c_str(), O_RDONLY);
+
+			if (descriptor < 0) {
+				return;
+			}
+
+			struct stat status{};
+
+			if (::fstat(descriptor, &status) == 0 && status.st_size > 0)
+			{
+				void* mapped = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+				if (mapped != MAP_FAILED) {
+					address = mapped;
+					size = static_cast<size_t>(status.st_size);
+				}
+			}
+
+			::close(descriptor);
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifndef _WIN32
+			if (address != nullptr) {
+				::munmap(address, size);
+			}
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) = delete;
+
+		auto operator=(const MappedFile&) -> MappedFile& = delete;
+		auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+
+		[[nodiscard]]
+		auto get_bytes() const -> std::span<const std::byte>
+		{
+#ifdef _WIN32
+			return contents;
+#else
+			return { static_cast<const std::byte*>(address), size };
+#endif
+		}
+	};
+}
+
+
+auto hash_source(const std::string_view source) -> uint64_t
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (const char c : source) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+auto get_cache_path(const std::filesystem::path& directory, const uint64_t source_hash) -> std::filesystem::path
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.hsbc", static_cast<unsigned long long>(source_hash));
+
+	return directory / name;
+}
+
+auto load_compiled_program(const std::filesystem::path& path, const std::string_view source) -> std::optional<BytecodeProgram>
+{
+	using namespace CacheFormat;
+
+	const MappedFile file{ path };
+	const std::span<const std::byte> bytes = file.get_bytes();
+
+	if (bytes.size() < sizeof(Header)) {
+		return std::nullopt;
+	}
+
+	Header header;
+	std::memcpy(&header, bytes.data(), sizeof(Header));
+
+	const std::span<const std::byte> payload = bytes.subspan(sizeof(Header));
+
+	if (header.magic != magic
+		|| header.version != version
+		|| header.source_hash != hash_source(source)
+		|| header.source_size != source.size()
+		|| header.source_digest != digest(source)
+		|| header.payload_size != payload.size()
+		|| header.payload_checksum != checksum(payload))
+	{
+		return std::nullopt;
+	}
+
+	Reader reader{ payload };
+	return read_program(reader);
+}
+
+auto save_compiled_program(const BytecodeProgram& program, const std::filesystem::path& path, const std::string_view source) -> bool
+{
+	using namespace CacheFormat;
+
+	Writer writer;
+	write_program(writer, program);
+
+	const std::string& payload = writer.get_buffer();
+	const Header header{
+		magic,
+		version,
+		hash_source(source),
+		source.size(),
+		digest(source),
+		payload.size(),
+		checksum(std::as_bytes(std::span{ payload.data(), payload.size() }))
+	};
+
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	// Written aside and renamed, so a concurrent run never maps a half-written file.
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+
+	{
+		std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+
+		if (!file) {
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include "bytecode.h"
+
+
+// --- Note ---
+// Compiled programs may be kept on disk, so running an unchanged script again skips
+// lexing, parsing, folding, resolving and compiling. A cache file holds the bytecode
+// of one source and is named after the hash of that source.
+//
+// The file starts with a header: a magic number, the version of the format, the hash,
+// the length and a second, independent hash of the source, and a checksum of everything
+// after the header. Sources colliding in the hash which names the file are told apart
+// by the other two. Every index in the
+// decoded program is then checked against the sizes it refers to. A file failing any
+// of these checks is ignored and overwritten by a freshly compiled program. The version
+// is bytecode_version, so a change of the compiler invalidates all files written by
+// earlier builds.
+//
+// Names are stored as text and interned when the file is loaded, since symbols are
+// only meaningful within one process.
+
+
+/// <summary>
+///	Returns the 64-bit FNV-1a hash of the source.
+/// </summary>
+[[nodiscard]]
+auto hash_source(std::string_view source) -> uint64_t;
+
+/// <summary>
+///	Returns the path of the cache file of the source with the given hash.
+/// </summary>
+[[nodiscard]]
+auto get_cache_path(const std::filesystem::path& directory, uint64_t source_hash) -> std::filesystem::path;
+
+/// <summary>
+///	Maps the cache file into memory and reads the program from it. Returns nothing when the file
+///	is missing, damaged, written by another version or for another source.
+/// </summary>
+[[nodiscard]]
+auto load_compiled_program(const std::filesystem::path& path, std::string_view source) -> std::optional<BytecodeProgram>;
+
+/// <summary>
+///	Writes the program to the cache file, creating the directory if needed. Returns false when it can not be written.
+/// </summary>
+auto save_compiled_program(const BytecodeProgram& program, const std::filesystem::path& path, std::string_view source) -> bool;
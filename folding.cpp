@@ -0,0 +1,351 @@
+#include "folding.h"
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
+
+
+Folder::Folder(Arena& arena)
+	: arena(arena)
+	, constants_context(stack, budget, nullptr, nullptr, &result)
+{
+}
+
+auto Folder::get_arena() -> Arena&
+{
+	return this->arena;
+}
+
+auto Folder::evaluate(ExpressionNode& constant_expression) -> Value
+{
+	return constant_expression.evaluate(this->constants_context);
+}
+
+void Folder::note_declaration()
+{
+	++this->declaration_count;
+}
+
+auto Folder::get_declaration_count() const -> size_t
+{
+	return this->declaration_count;
+}
+
+void Folder::restore_declaration_count(const size_t count)
+{
+	this->declaration_count = count;
+}
+
+auto Folder::can_fold(const UnaryOperation operation, const Value& operand) -> bool
+{
+	switch (operation) {
+		case UnaryOperation::Not:
+			return operand.try_get<Value::Logic>() != nullptr;
+
+		case UnaryOperation::Negate:
+		{
+			const Value::Number* number = operand.try_get<Value::Number>();
+			return number != nullptr && *number != std::numeric_limits<Value::Number>::min();
+		}
+	}
+
+	return false;
+}
+
+auto Folder::can_fold(
+	const BinaryOperationNode::OperationVariant& operation,
+	const Value& left,
+	const Value& right) -> bool
+{
+	const Value::Number* left_number = left.try_get<Value::Number>();
+	const Value::Number* right_number = right.try_get<Value::Number>();
+	const bool are_numbers = left_number != nullptr && right_number != nullptr;
+	const bool are_logic = left.try_get<Value::Logic>() != nullptr && right.try_get<Value::Logic>() != nullptr;
+
+	if (const auto* arithmetic = std::get_if<ArithmeticOperation>(&operation))
+	{
+		if (!are_numbers) {
+			return false;
+		}
+
+		const int64_t l = *left_number;
+		const int64_t r = *right_number;
+		int64_t wide_result;
+
+		switch (*arithmetic) {
+			case ArithmeticOperation::Addition:			wide_result = l + r; break;
+			case ArithmeticOperation::Substraction:		wide_result = l - r; break;
+			case ArithmeticOperation::Multiplication:	wide_result = l * r; break;
+			case ArithmeticOperation::Division:
+			case ArithmeticOperation::Modulo:
+				if (r == 0) {
+					return false;
+				}
+				wide_result = l / r;
+				break;
+			default:
+				return false;
+		}
+
+		return wide_result >= std::numeric_limits<Value::Number>::min()
+			&& wide_result <= std::numeric_limits<Value::Number>::max();
+	}
+
+	if (std::holds_alternative<LogicOperation>(operation)) {
+		return are_logic;
+	}
+
+	if (const auto* comparison = std::get_if<ComparisonOperation>(&operation))
+	{
+		if (are_logic) {
+			return *comparison == ComparisonOperation::Equality
+				|| *comparison == ComparisonOperation::Inequality;
+		}
+
+		return are_numbers;
+	}
+
+	return false;
+}
+
+auto Folder::try_get_direct_operand(ExpressionNode& expression) -> std::optional<DirectOperand>
+{
+	if (VariableReferenceNode* variable = expression.try_get_variable()) {
+		return DirectOperand{ variable, Value{} };
+	}
+
+	const Value* constant = expression.try_get_constant();
+
+	if (constant == nullptr || constant->get_type() != Value::Type::Number) {
+		return std::nullopt;
+	}
+
+	return DirectOperand{ nullptr, *constant };
+}
+
+
+// Replaces a loop comparing two numbers, each a variable or a literal, with a ComparisonLoopNode.
+auto fuse_loop(Folder& folder, ConditionalStatementNode& loop, ExpressionNode& condition) -> StatementNode*
+{
+	const BinaryOperationNode* operation = condition.try_get_binary_operation();
+	const auto* comparison = operation != nullptr ? std::get_if<ComparisonOperation>(&operation->get_operation()) : nullptr;
+
+	if (comparison == nullptr) {
+		return &loop;
+	}
+
+	std::optional<DirectOperand> left = Folder::try_get_direct_operand(*operation->get_left_child());
+	std::optional<DirectOperand> right = Folder::try_get_direct_operand(*operation->get_right_child());
+
+	if (!left.has_value() || !right.has_value()) {
+		return &loop;
+	}
+
+	ComparisonLoopNode* fused = folder.get_arena().make<ComparisonLoopNode>(&loop, *comparison, std::move(*left), std::move(*right));
+	fused->set_location(loop.get_location());
+	return fused;
+}
+
+
+void AstRoot::fold(Arena& arena)
+{
+	Folder folder{ arena };
+	this->head_statement = this->head_statement->fold_statement(folder);
+}
+
+
+auto ExpressionNode::try_get_constant() const -> const Value*
+{
+	return nullptr;
+}
+
+auto LiteralNode::try_get_constant() const -> const Value*
+{
+	return &this->value;
+}
+
+
+auto BraceExpressionNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	return this->braced_expression->fold_expression(folder);
+}
+
+auto LiteralNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	return this;
+}
+
+auto UnaryOperationNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	this->child = this->child->fold_expression(folder);
+
+	const Value* operand = this->child->try_get_constant();
+
+	if (operand == nullptr || !Folder::can_fold(this->operator_, *operand)) {
+		return this;
+	}
+
+	return folder.get_arena().make<LiteralNode>(folder.evaluate(*this));
+}
+
+auto BinaryOperationNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	this->left_child = this->left_child->fold_expression(folder);
+	this->right_child = this->right_child->fold_expression(folder);
+
+	const Value* left = this->left_child->try_get_constant();
+	const Value* right = this->right_child->try_get_constant();
+
+	if (left == nullptr || right == nullptr || !Folder::can_fold(this->operation_, *left, *right)) {
+		return this;
+	}
+
+	return folder.get_arena().make<LiteralNode>(folder.evaluate(*this));
+}
+
+auto VariableReferenceNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	return this;
+}
+
+auto TypedBinaryOperationNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	return this;
+}
+
+auto TypedUnaryOperationNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	return this;
+}
+
+
+auto BlockNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	std::vector<StatementNode*> folded;
+	folded.reserve(this->statements.size());
+
+	for (StatementNode* statement : this->statements)
+	{
+		if (StatementNode* replacement = statement->fold_statement(folder)) {
+			folded.push_back(replacement);
+		}
+	}
+
+	if (folded.size() != this->statements.size()
+		|| !std::equal(folded.begin(), folded.end(), this->statements.begin()))
+	{
+		this->statements = folder.get_arena().copy_array(std::span<StatementNode* const>{ folded });
+	}
+
+	return this;
+}
+
+auto BodyNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	this->body_statement = this->body_statement->fold_statement(folder);
+	return this;
+}
+
+auto ResultNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	this->result_expression = this->result_expression->fold_expression(folder);
+	return this;
+}
+
+auto VariableAssignmentNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	this->expression = this->expression->fold_expression(folder);
+
+	if (!this->is_reassignment) {
+		folder.note_declaration();
+		return this;
+	}
+
+	const BinaryOperationNode* operation = this->expression->try_get_binary_operation();
+	const auto* arithmetic = operation != nullptr ? std::get_if<ArithmeticOperation>(&operation->get_operation()) : nullptr;
+
+	if (arithmetic == nullptr || (*arithmetic != ArithmeticOperation::Addition && *arithmetic != ArithmeticOperation::Substraction)) {
+		return this;
+	}
+
+	const VariableReferenceNode* variable = operation->get_left_child()->try_get_variable();
+	const Value* constant = operation->get_right_child()->try_get_constant();
+
+	if (variable == nullptr || variable->get_name() != this->variable_name || constant == nullptr || constant->get_type() != Value::Type::Number) {
+		return this;
+	}
+
+	// Subtracting wraps around like adding the negated number, even for the lowest one.
+	const Value::Number number = constant->get_unchecked<Value::Number>();
+	const Value::Number amount = *arithmetic == ArithmeticOperation::Addition ? number : NumberArithmetic::negate(number);
+
+	IncrementNode* increment = folder.get_arena().make<IncrementNode>(this->variable_name, amount);
+	increment->set_location(this->get_location());
+	return increment;
+}
+
+auto ConditionalStatementNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	this->condition = this->condition->fold_expression(folder);
+
+	const size_t outer_declarations = folder.get_declaration_count();
+	this->statement = this->statement->fold_statement(folder);
+	const bool declares_names = folder.get_declaration_count() != outer_declarations;
+	folder.restore_declaration_count(outer_declarations);
+
+	const Value* constant = this->condition->try_get_constant();
+	const Value::Logic* condition_value = constant != nullptr ? constant->try_get<Value::Logic>() : nullptr;
+
+	// Non-logic conditions still have to fail when reached.
+	if (condition_value == nullptr) {
+		return this->repeating ? fuse_loop(folder, *this, *this->condition) : this;
+	}
+
+	if (!*condition_value) {
+		return nullptr;
+	}
+
+	// The body takes the place of the whole statement, reports included.
+	if (!this->repeating && !declares_names) {
+		this->statement->set_location(this->get_location());
+		return this->statement;
+	}
+
+	return this;
+}
+
+auto IncrementNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	return this;
+}
+
+auto ComparisonLoopNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	return this;
+}
+
+auto FunctionDeclarationNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	const size_t outer_declarations = folder.get_declaration_count();
+	this->body = this->body->fold_statement(folder);
+	folder.restore_declaration_count(outer_declarations);
+
+	folder.note_declaration();
+	return this;
+}
+
+auto FunctionCallNode::fold_expression(Folder& folder) -> ExpressionNode*
+{
+	return this;
+}
+
+auto FunctionCallNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	return this;
+}
+
+auto PrintNode::fold_statement(Folder& folder) -> StatementNode*
+{
+	return this;
+}
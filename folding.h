@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+#include "arena.h"
+#include "ast.h"
+
+
+// --- Note ---
+// Folding runs once, right after parsing, and rewrites the tree in place.
+// An operation on literals is replaced by its result only when evaluating it
+// can not fail. Illegal combinations (like adding a boolean to a number, or
+// dividing by zero) are left untouched, so they still fail at runtime, and
+// only if the program actually reaches them.
+//
+// A conditional whose condition is the literal false is removed. One with
+// the literal true is replaced by its body, unless the body declares names:
+// these must vanish together with the scope of the conditional.
+//
+// Increments of a variable and loops comparing two numbers are replaced by fused
+// nodes (see IncrementNode and ComparisonLoopNode).
+
+
+class Folder final
+{
+	Arena& arena;
+
+	std::optional<Value> result;
+	ValueStack stack;
+	ExecutionBudget budget{ ExecutionLimits{} };
+	ExecutionScopedState constants_context;	// Literals never look into it.
+
+	size_t declaration_count = 0;
+
+public:
+	explicit Folder(Arena& arena);
+
+
+	[[nodiscard]]
+	auto get_arena() -> Arena&;
+
+	/// <summary>
+	///	Evaluates an expression built only of literals.
+	/// </summary>
+	[[nodiscard]]
+	auto evaluate(ExpressionNode& constant_expression) -> Value;
+
+
+	void note_declaration();
+
+	[[nodiscard]]
+	auto get_declaration_count() const -> size_t;
+
+	/// <summary>
+	///	Forgets declarations made in a nested scope which has been folded.
+	/// </summary>
+	void restore_declaration_count(size_t count);
+
+
+	/// <summary>
+	///	Checks if the operation applied to the value succeeds.
+	/// </summary>
+	[[nodiscard]]
+	static auto can_fold(UnaryOperation operation, const Value& operand) -> bool;
+
+	/// <summary>
+	///	Checks if the operation applied to the values succeeds and does not overflow.
+	/// </summary>
+	[[nodiscard]]
+	static auto can_fold(const BinaryOperationNode::OperationVariant& operation, const Value& left, const Value& right) -> bool;
+
+	/// <summary>
+	///	Returns the expression as an operand of a fused node, when it is a variable or a number literal.
+	/// </summary>
+	[[nodiscard]]
+	static auto try_get_direct_operand(ExpressionNode& expression) -> std::optional<DirectOperand>;
+};
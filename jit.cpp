@@ -0,0 +1,857 @@
+#include "jit.h"
+
+#include <cstddef>
+#include <cstring>
+#include <optional>
+
+#if HOMEWORKSCRIPT_JIT
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+
+namespace JitCompilation
+{
+	// Type of a register as far as the compiler knows. Extends RegisterType with an unknown type.
+	using TypeState = std::vector<uint8_t>;
+
+	constexpr uint8_t unknown_type = 0xFF;
+
+	constexpr size_t max_analysis_size = size_t{ 1 } << 22;
+
+	constexpr auto type_of(const RegisterType type) -> uint8_t
+	{
+		return static_cast<uint8_t>(type);
+	}
+
+	static_assert(sizeof(RegisterValue) == 8, "Registers are addressed as 8-byte slots.");
+
+	auto type_offset(const uint16_t index) -> int32_t
+	{
+		return static_cast<int32_t>(index * sizeof(RegisterValue) + offsetof(RegisterValue, type));
+	}
+
+	auto payload_offset(const uint16_t index) -> int32_t
+	{
+		return static_cast<int32_t>(index * sizeof(RegisterValue) + offsetof(RegisterValue, payload));
+	}
+
+
+	auto is_arithmetic(const OpCode op) -> bool
+	{
+		return op >= OpCode::Add && op <= OpCode::Modulo;
+	}
+
+	auto is_logic(const OpCode op) -> bool
+	{
+		return op >= OpCode::And && op <= OpCode::Xor;
+	}
+
+	auto is_comparison(const OpCode op) -> bool
+	{
+		return op >= OpCode::Equal && op <= OpCode::MoreOrEqual;
+	}
+
+	auto is_number_or_logic(const uint8_t type) -> bool
+	{
+		return type == type_of(RegisterType::Number) || type == type_of(RegisterType::Logic);
+	}
+
+	// Instructions the compiler knows at all. Others always leave the machine code.
+	auto is_compilable(const OpCode op) -> bool
+	{
+		switch (op) {
+			case OpCode::LoadConstant:
+			case OpCode::Move:
+			case OpCode::Reassign:
+			case OpCode::Not:
+			case OpCode::Negate:
+			case OpCode::Jump:
+			case OpCode::JumpIfFalse:
+			case OpCode::Loop:
+				return true;
+			default:
+				return is_arithmetic(op) || is_logic(op) || is_comparison(op);
+		}
+	}
+
+	// Whether the instruction is compiled with the given types, instead of leaving the machine code.
+	auto is_executable(const Instruction& instruction, const TypeState& types) -> bool
+	{
+		const OpCode op = instruction.op;
+		const uint8_t number = type_of(RegisterType::Number);
+		const uint8_t logic = type_of(RegisterType::Logic);
+
+		if (is_arithmetic(op)) {
+			return types[instruction.b] == number && types[instruction.c] == number;
+		}
+
+		if (is_logic(op)) {
+			return types[instruction.b] == logic && types[instruction.c] == logic;
+		}
+
+		if (is_comparison(op))
+		{
+			if (types[instruction.b] != types[instruction.c]) {
+				return false;
+			}
+
+			const bool is_equality = op == OpCode::Equal || op == OpCode::NotEqual;
+			return types[instruction.b] == number || (is_equality && types[instruction.b] == logic);
+		}
+
+		switch (op) {
+			case OpCode::LoadConstant:
+			case OpCode::Move:
+			case OpCode::Jump:
+			case OpCode::Loop:
+				return true;
+			case OpCode::Reassign:
+				return types[instruction.a] == types[instruction.b] && is_number_or_logic(types[instruction.a]);
+			case OpCode::Not:
+				return types[instruction.b] == logic;
+			case OpCode::Negate:
+				return types[instruction.b] == number;
+			case OpCode::JumpIfFalse:
+				return types[instruction.a] == logic;
+			default:
+				return false;
+		}
+	}
+
+	// Type of the register written by an executable instruction.
+	auto get_result_type(const Instruction& instruction, const FunctionPrototype& prototype, const TypeState& types) -> uint8_t
+	{
+		const OpCode op = instruction.op;
+
+		if (is_arithmetic(op) || op == OpCode::Negate) {
+			return type_of(RegisterType::Number);
+		}
+
+		if (is_logic(op) || is_comparison(op) || op == OpCode::Not) {
+			return type_of(RegisterType::Logic);
+		}
+
+		switch (op) {
+			case OpCode::LoadConstant:	return type_of(prototype.constants[instruction.b].type);
+			case OpCode::Move:			return types[instruction.b];
+			case OpCode::Reassign:		return types[instruction.b];
+			default:					return unknown_type;
+		}
+	}
+
+	auto writes_register(const OpCode op) -> bool
+	{
+		return op != OpCode::Jump && op != OpCode::JumpIfFalse && op != OpCode::Loop;
+	}
+
+	// Registers read by the instruction, at most two.
+	auto get_reads(const Instruction& instruction, uint16_t (&reads)[2]) -> size_t
+	{
+		const OpCode op = instruction.op;
+
+		if (is_arithmetic(op) || is_logic(op) || is_comparison(op)) {
+			reads[0] = instruction.b;
+			reads[1] = instruction.c;
+			return 2;
+		}
+
+		switch (op) {
+			case OpCode::Reassign:
+				reads[0] = instruction.a;
+				reads[1] = instruction.b;
+				return 2;
+			case OpCode::Move:
+			case OpCode::Not:
+			case OpCode::Negate:
+				reads[0] = instruction.b;
+				return 1;
+			case OpCode::JumpIfFalse:
+				reads[0] = instruction.a;
+				return 1;
+			default:
+				return 0;
+		}
+	}
+
+	// Positions control may continue at after an executable instruction.
+	auto get_successors(const Instruction& instruction, const uint32_t pc, uint32_t (&successors)[2]) -> size_t
+	{
+		switch (instruction.op) {
+			case OpCode::Jump:
+			case OpCode::Loop:
+				successors[0] = instruction.target();
+				return 1;
+			case OpCode::JumpIfFalse:
+				successors[0] = pc + 1;
+				successors[1] = instruction.target();
+				return 2;
+			default:
+				successors[0] = pc + 1;
+				return 1;
+		}
+	}
+
+
+	class Assembler final
+	{
+		std::vector<uint8_t> bytes;
+
+	public:
+		void put(const uint8_t byte)
+		{
+			bytes.push_back(byte);
+		}
+
+		void put(std::initializer_list<uint8_t> sequence)
+		{
+			bytes.insert(bytes.end(), sequence);
+		}
+
+		void put_dword(const uint32_t value)
+		{
+			for (int i = 0; i < 4; ++i) {
+				bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+			}
+		}
+
+		// Instruction on [rdi + offset], opcode bytes followed by ModRM with the given register field.
+		void put_memory(std::initializer_list<uint8_t> opcode, const uint8_t reg, const int32_t offset)
+		{
+			put(opcode);
+			put(static_cast<uint8_t>(0x87 | (reg << 3)));
+			put_dword(static_cast<uint32_t>(offset));
+		}
+
+		// Emits the opcode bytes of a jump with a 32-bit displacement, returns where to patch it.
+		auto put_jump(std::initializer_list<uint8_t> opcode) -> size_t
+		{
+			put(opcode);
+			put_dword(0);
+			return bytes.size() - 4;
+		}
+
+		void patch_jump(const size_t at, const size_t target)
+		{
+			const auto displacement = static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + 4));
+			std::memcpy(bytes.data() + at, &displacement, 4);
+		}
+
+		[[nodiscard]]
+		auto position() const -> size_t
+		{
+			return bytes.size();
+		}
+
+		[[nodiscard]]
+		auto get_bytes() const -> const std::vector<uint8_t>&
+		{
+			return bytes;
+		}
+	};
+
+	constexpr uint8_t eax = 0;
+	constexpr uint8_t ecx = 1;
+
+	// Condition codes (the low nibble of Jcc/SETcc) of the comparisons.
+	auto get_condition(const OpCode op) -> uint8_t
+	{
+		switch (op) {
+			case OpCode::Equal:			return 0x4;
+			case OpCode::NotEqual:		return 0x5;
+			case OpCode::Less:			return 0xC;
+			case OpCode::LessOrEqual:	return 0xE;
+			case OpCode::More:			return 0xF;
+			default:					return 0xD;	// MoreOrEqual
+		}
+	}
+
+
+	// Compiles the code reachable from one position of a prototype.
+	class RegionCompiler final
+	{
+		const FunctionPrototype* prototype;
+		uint32_t entry;
+		const RegisterValue* registers;
+
+		std::vector<bool> reachable;
+		std::vector<bool> is_jump_target;
+		std::vector<TypeState> types;
+		TypeState entry_types;
+
+		Assembler assembler;
+		std::vector<size_t> labels;
+		std::vector<std::pair<size_t, uint32_t>> jumps;		// Displacement and the target position.
+		std::vector<std::pair<size_t, uint32_t>> exits;		// Displacement and the position the VM resumes at.
+
+		// What the emitter knows between jump targets.
+		std::optional<uint16_t> register_in_eax;
+		std::vector<std::optional<int32_t>> constants;
+
+
+		auto get_code() const -> const std::vector<Instruction>&
+		{
+			return prototype->code;
+		}
+
+		void find_entry_types()
+		{
+			const auto& code = get_code();
+			const size_t register_count = prototype->register_count;
+
+			// Registers read before being written, found backwards from the instructions which may be compiled.
+			std::vector<std::vector<bool>> live(code.size() + 1, std::vector<bool>(register_count, false));
+			bool changed = true;
+
+			while (changed)
+			{
+				changed = false;
+
+				for (size_t pc = code.size(); pc-- > 0;)
+				{
+					const Instruction& instruction = code[pc];
+
+					if (!is_compilable(instruction.op)) {
+						continue;
+					}
+
+					std::vector<bool> in(register_count, false);
+					uint32_t successors[2];
+
+					for (size_t i = 0, count = get_successors(instruction, static_cast<uint32_t>(pc), successors); i < count; ++i) {
+						for (size_t r = 0; r < register_count; ++r) {
+							in[r] = in[r] || live[successors[i]][r];
+						}
+					}
+
+					if (writes_register(instruction.op)) {
+						in[instruction.a] = false;
+					}
+
+					uint16_t reads[2];
+					for (size_t i = 0, count = get_reads(instruction, reads); i < count; ++i) {
+						in[reads[i]] = true;
+					}
+
+					if (in != live[pc]) {
+						live[pc] = std::move(in);
+						changed = true;
+					}
+				}
+			}
+
+			entry_types.assign(register_count, unknown_type);
+
+			for (size_t r = 0; r < register_count; ++r) {
+				if (live[entry][r] && is_number_or_logic(type_of(registers[r].type))) {
+					entry_types[r] = type_of(registers[r].type);
+				}
+			}
+		}
+
+		void infer_types()
+		{
+			const auto& code = get_code();
+
+			reachable.assign(code.size(), false);
+			is_jump_target.assign(code.size(), false);
+			types.assign(code.size(), TypeState{});
+
+			std::vector<uint32_t> worklist{ entry };
+			reachable[entry] = true;
+			is_jump_target[entry] = true;
+			types[entry] = entry_types;
+
+			while (!worklist.empty())
+			{
+				const uint32_t pc = worklist.back();
+				worklist.pop_back();
+
+				const Instruction& instruction = code[pc];
+
+				if (!is_compilable(instruction.op) || !is_executable(instruction, types[pc])) {
+					continue;
+				}
+
+				TypeState out = types[pc];
+
+				if (writes_register(instruction.op)) {
+					out[instruction.a] = get_result_type(instruction, *prototype, types[pc]);
+				}
+
+				uint32_t successors[2];
+
+				for (size_t i = 0, count = get_successors(instruction, pc, successors); i < count; ++i)
+				{
+					const uint32_t next = successors[i];
+
+					if (next != pc + 1) {
+						is_jump_target[next] = true;
+					}
+
+					if (!reachable[next]) {
+						reachable[next] = true;
+						types[next] = out;
+						worklist.push_back(next);
+						continue;
+					}
+
+					bool widened = false;
+
+					for (size_t r = 0; r < out.size(); ++r) {
+						if (types[next][r] != out[r] && types[next][r] != unknown_type) {
+							types[next][r] = unknown_type;
+							widened = true;
+						}
+					}
+
+					if (widened) {
+						worklist.push_back(next);
+					}
+				}
+			}
+		}
+
+
+		void forget_known_values()
+		{
+			register_in_eax.reset();
+			constants.assign(prototype->register_count, std::nullopt);
+		}
+
+		void load(const uint16_t index)
+		{
+			if (constants[index].has_value()) {
+				assembler.put(0xB8);	// mov eax, imm32
+				assembler.put_dword(static_cast<uint32_t>(*constants[index]));
+			}
+			else if (register_in_eax != index) {
+				assembler.put_memory({ 0x8B }, eax, payload_offset(index));	// mov eax, [payload]
+			}
+
+			register_in_eax = index;
+		}
+
+		void store_type(const uint16_t index, const uint8_t known_type, const uint8_t type)
+		{
+			if (known_type != type) {
+				assembler.put_memory({ 0xC7 }, 0, type_offset(index));	// mov dword [type], imm32
+				assembler.put_dword(type);
+			}
+		}
+
+		// Stores eax as the payload of the register.
+		void store(const uint16_t index, const TypeState& state, const uint8_t type)
+		{
+			assembler.put_memory({ 0x89 }, eax, payload_offset(index));	// mov [payload], eax
+			store_type(index, state[index], type);
+
+			register_in_eax = index;
+			constants[index].reset();
+		}
+
+		void store_constant(const uint16_t index, const TypeState& state, const RegisterValue& value)
+		{
+			assembler.put_memory({ 0xC7 }, 0, payload_offset(index));	// mov dword [payload], imm32
+			assembler.put_dword(static_cast<uint32_t>(value.payload));
+			store_type(index, state[index], type_of(value.type));
+
+			if (register_in_eax == index) {
+				register_in_eax.reset();
+			}
+
+			constants[index] = value.payload;
+		}
+
+		// Applies the operation to eax and the right operand: an immediate when the register is known, memory otherwise.
+		void apply(const uint8_t memory_opcode, const uint8_t immediate_opcode, const uint16_t right)
+		{
+			if (constants[right].has_value()) {
+				assembler.put(immediate_opcode);
+				assembler.put_dword(static_cast<uint32_t>(*constants[right]));
+			}
+			else {
+				assembler.put_memory({ memory_opcode }, eax, payload_offset(right));
+			}
+		}
+
+		void jump_to(std::initializer_list<uint8_t> opcode, const uint32_t target)
+		{
+			jumps.emplace_back(assembler.put_jump(opcode), target);
+		}
+
+		void exit_to(std::initializer_list<uint8_t> opcode, const uint32_t pc)
+		{
+			exits.emplace_back(assembler.put_jump(opcode), pc);
+		}
+
+		void emit_return(const uint32_t pc)
+		{
+			assembler.put(0xB8);	// mov eax, pc
+			assembler.put_dword(pc);
+			assembler.put(0xC3);	// ret
+		}
+
+
+		void emit_arithmetic(const Instruction& instruction, const TypeState& state, const uint32_t pc)
+		{
+			load(instruction.b);
+
+			switch (instruction.op) {
+				case OpCode::Add:
+					apply(0x03, 0x05, instruction.c);	// add eax, ...
+					break;
+				case OpCode::Subtract:
+					apply(0x2B, 0x2D, instruction.c);	// sub eax, ...
+					break;
+				case OpCode::Multiply:
+					if (constants[instruction.c].has_value()) {
+						assembler.put({ 0x69, 0xC0 });	// imul eax, eax, imm32
+						assembler.put_dword(static_cast<uint32_t>(*constants[instruction.c]));
+					}
+					else {
+						assembler.put_memory({ 0x0F, 0xAF }, eax, payload_offset(instruction.c));	// imul eax, [payload]
+					}
+					break;
+				default:
+				{
+					// Dividing by zero, or by -1 which may overflow, is left to the VM.
+					if (constants[instruction.c].has_value()) {
+						assembler.put(0xB9);	// mov ecx, imm32
+						assembler.put_dword(static_cast<uint32_t>(*constants[instruction.c]));
+					}
+					else {
+						assembler.put_memory({ 0x8B }, ecx, payload_offset(instruction.c));	// mov ecx, [payload]
+					}
+
+					assembler.put({ 0x8D, 0x51, 0x01 });	// lea edx, [rcx + 1]
+					assembler.put({ 0x83, 0xFA, 0x01 });	// cmp edx, 1
+					exit_to({ 0x0F, 0x86 }, pc);			// jbe exit
+					assembler.put({ 0x99, 0xF7, 0xF9 });	// cdq, idiv ecx
+
+					if (instruction.op == OpCode::Modulo) {
+						assembler.put({ 0x89, 0xD0 });		// mov eax, edx
+					}
+				}
+			}
+
+			store(instruction.a, state, type_of(RegisterType::Number));
+		}
+
+		// Returns true when the following JumpIfFalse has been folded into the comparison.
+		auto emit_comparison(const Instruction& instruction, const TypeState& state, const uint32_t pc) -> bool
+		{
+			const uint8_t condition = get_condition(instruction.op);
+
+			load(instruction.b);
+			apply(0x3B, 0x3D, instruction.c);								// cmp eax, ...
+			assembler.put({ 0x0F, static_cast<uint8_t>(0x90 | condition), 0xC0 });	// setcc al
+			assembler.put({ 0x0F, 0xB6, 0xC0 });							// movzx eax, al
+			store(instruction.a, state, type_of(RegisterType::Logic));
+
+			const auto& code = get_code();
+			const uint32_t next = pc + 1;
+
+			if (next >= code.size() || !reachable[next] || is_jump_target[next]) {
+				return false;
+			}
+
+			const Instruction& branch = code[next];
+
+			if (branch.op != OpCode::JumpIfFalse || branch.a != instruction.a || !is_executable(branch, types[next])) {
+				return false;
+			}
+
+			// The flags still hold the comparison: jump on the opposite condition.
+			labels[next] = assembler.position();
+			jump_to({ 0x0F, static_cast<uint8_t>(0x80 | (condition ^ 1)) }, branch.target());
+			return true;
+		}
+
+		// Emits one instruction. Returns false when control does not fall through to the next position.
+		auto emit(const uint32_t pc, bool& skip_next) -> bool
+		{
+			const Instruction& instruction = get_code()[pc];
+			const TypeState& state = types[pc];
+
+			if (!is_compilable(instruction.op) || !is_executable(instruction, state)) {
+				emit_return(pc);
+				return false;
+			}
+
+			if (is_arithmetic(instruction.op)) {
+				emit_arithmetic(instruction, state, pc);
+				return true;
+			}
+
+			if (is_comparison(instruction.op)) {
+				skip_next = emit_comparison(instruction, state, pc);
+				return true;
+			}
+
+			switch (instruction.op)
+			{
+				case OpCode::And:
+				case OpCode::Or:
+				case OpCode::Xor:
+				{
+					const uint8_t memory_opcode = instruction.op == OpCode::And ? 0x23 : instruction.op == OpCode::Or ? 0x0B : 0x33;
+					load(instruction.b);
+					apply(memory_opcode, static_cast<uint8_t>(memory_opcode + 2), instruction.c);
+					store(instruction.a, state, type_of(RegisterType::Logic));
+					return true;
+				}
+
+				case OpCode::LoadConstant:
+					store_constant(instruction.a, state, prototype->constants[instruction.b]);
+					return true;
+
+				case OpCode::Move:
+				case OpCode::Reassign:
+				{
+					if (constants[instruction.b].has_value() && is_number_or_logic(state[instruction.b])) {
+						const RegisterValue value{ static_cast<RegisterType>(state[instruction.b]), *constants[instruction.b] };
+						store_constant(instruction.a, state, value);
+					}
+					else if (is_number_or_logic(state[instruction.b])) {
+						load(instruction.b);
+						store(instruction.a, state, state[instruction.b]);
+					}
+					else {
+						// The type is not known, the whole register is copied.
+						assembler.put_memory({ 0x48, 0x8B }, eax, type_offset(instruction.b));	// mov rax, [register]
+						assembler.put_memory({ 0x48, 0x89 }, eax, type_offset(instruction.a));	// mov [register], rax
+						register_in_eax.reset();
+						constants[instruction.a].reset();
+					}
+					return true;
+				}
+
+				case OpCode::Not:
+					load(instruction.b);
+					assembler.put({ 0x83, 0xF0, 0x01 });	// xor eax, 1
+					store(instruction.a, state, type_of(RegisterType::Logic));
+					return true;
+
+				case OpCode::Negate:
+					load(instruction.b);
+					assembler.put({ 0xF7, 0xD8 });			// neg eax
+					store(instruction.a, state, type_of(RegisterType::Number));
+					return true;
+
+				case OpCode::Jump:
+					jump_to({ 0xE9 }, instruction.target());
+					return false;
+
+				case OpCode::JumpIfFalse:
+					load(instruction.a);
+					assembler.put({ 0x85, 0xC0 });			// test eax, eax
+					jump_to({ 0x0F, 0x84 }, instruction.target());
+					return true;
+
+				case OpCode::Loop:
+					// The VM refills the budget by running the Loop itself.
+					assembler.put({ 0x83, 0x3E, 0x00 });	// cmp dword [rsi], 0
+					exit_to({ 0x0F, 0x84 }, pc);
+					assembler.put({ 0xFF, 0x0E });			// dec dword [rsi]
+					jump_to({ 0xE9 }, instruction.target());
+					return false;
+
+				default:
+					emit_return(pc);
+					return false;
+			}
+		}
+
+		void emit_guards()
+		{
+			std::vector<size_t> failures;
+
+			for (uint16_t r = 0; r < entry_types.size(); ++r)
+			{
+				if (entry_types[r] == unknown_type) {
+					continue;
+				}
+
+				assembler.put_memory({ 0x80 }, 7, type_offset(r));	// cmp byte [type], imm8
+				assembler.put(entry_types[r]);
+				failures.push_back(assembler.put_jump({ 0x0F, 0x85 }));
+			}
+
+			jump_to({ 0xE9 }, entry);
+
+			for (const size_t failure : failures) {
+				assembler.patch_jump(failure, assembler.position());
+			}
+
+			if (!failures.empty()) {
+				emit_return(NativeCode::guard_failed);
+			}
+		}
+
+	public:
+		explicit RegionCompiler(const FunctionPrototype& prototype, const uint32_t entry, const RegisterValue* registers)
+			: prototype(&prototype)
+			, entry(entry)
+			, registers(registers)
+		{
+		}
+
+		/// <summary>
+		///	Returns the machine code, or nothing when not even the entry instruction can be compiled.
+		/// </summary>
+		auto compile() -> std::optional<std::vector<uint8_t>>
+		{
+			const auto& code = get_code();
+
+			if (entry >= code.size() || !is_compilable(code[entry].op)) {
+				return std::nullopt;
+			}
+
+			// The analysis keeps the types of all registers at every position.
+			if (code.size() * prototype->register_count > max_analysis_size) {
+				return std::nullopt;
+			}
+
+			find_entry_types();
+			infer_types();
+
+			if (!is_executable(code[entry], types[entry])) {
+				return std::nullopt;
+			}
+
+			labels.assign(code.size(), 0);
+			forget_known_values();
+			emit_guards();
+
+			bool falls_through = false;
+			bool skip_next = false;
+
+			for (uint32_t pc = 0; pc < code.size(); ++pc)
+			{
+				if (skip_next) {
+					skip_next = false;
+					continue;
+				}
+
+				if (!reachable[pc]) {
+					falls_through = false;
+					continue;
+				}
+
+				if (!falls_through || is_jump_target[pc]) {
+					forget_known_values();
+				}
+
+				labels[pc] = assembler.position();
+				falls_through = emit(pc, skip_next);
+			}
+
+			for (const auto& [at, target] : jumps) {
+				assembler.patch_jump(at, labels[target]);
+			}
+
+			for (const auto& [at, pc] : exits) {
+				assembler.patch_jump(at, assembler.position());
+				emit_return(pc);
+			}
+
+			return assembler.get_bytes();
+		}
+	};
+}
+
+
+NativeCode::NativeCode(const std::vector<uint8_t>& bytes)
+{
+#if HOMEWORKSCRIPT_JIT
+	const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+	const size_t length = (bytes.size() + page - 1) / page * page;
+
+	void* mapped = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (mapped == MAP_FAILED) {
+		return;
+	}
+
+	// Never writable and executable at once.
+	std::memcpy(mapped, bytes.data(), bytes.size());
+
+	if (::mprotect(mapped, length, PROT_READ | PROT_EXEC) != 0) {
+		::munmap(mapped, length);
+		return;
+	}
+
+	memory = mapped;
+	size = length;
+#endif
+}
+
+NativeCode::~NativeCode()
+{
+#if HOMEWORKSCRIPT_JIT
+	if (memory != nullptr) {
+		::munmap(memory, size);
+	}
+#endif
+}
+
+auto NativeCode::is_valid() const -> bool
+{
+	return memory != nullptr;
+}
+
+
+Jit::Jit(const BytecodeProgram& program)
+	: program(&program)
+	, hot_spots(program.prototypes.size())
+{
+}
+
+auto Jit::get_hot_spot(const FunctionPrototype& prototype, const uint32_t pc) -> HotSpot&
+{
+	std::vector<HotSpot>& spots = hot_spots[static_cast<size_t>(&prototype - program->prototypes.data())];
+
+	if (spots.empty()) {
+		spots.resize(prototype.code.size());
+	}
+
+	return spots[pc];
+}
+
+void Jit::compile(HotSpot& spot, const FunctionPrototype& prototype, const uint32_t pc, const RegisterValue* registers)
+{
+	spot.heat = 0;
+	++spot.compilations;
+
+	if constexpr (HOMEWORKSCRIPT_JIT)
+	{
+		JitCompilation::RegionCompiler compiler{ prototype, pc, registers };
+
+		if (const auto bytes = compiler.compile())
+		{
+			auto code = std::make_unique<NativeCode>(*bytes);
+
+			if (code->is_valid()) {
+				spot.code = std::move(code);
+				return;
+			}
+		}
+	}
+
+	// Nothing worth running natively starts here.
+	spot.compilations = max_compilations;
+}
+
+auto Jit::run(HotSpot& spot, const uint32_t pc, RegisterValue* registers, ExecutionBudget& budget) -> uint32_t
+{
+	const uint32_t resume = spot.code->run(registers, budget.get_countdown());
+
+	// The types have changed since the code was compiled. It is compiled again once the position is hot again.
+	if (resume == NativeCode::guard_failed) {
+		spot.code.reset();
+		return pc;
+	}
+
+	return resume;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "budget.h"
+#include "bytecode.h"
+
+
+// Machine code is generated only for Linux on x86-64. Elsewhere, or compiled with
+// HOMEWORKSCRIPT_JIT=0, nothing is ever compiled and the VM interprets everything.
+#ifndef HOMEWORKSCRIPT_JIT
+	#if defined(__x86_64__) && defined(__linux__)
+		#define HOMEWORKSCRIPT_JIT 1
+	#else
+		#define HOMEWORKSCRIPT_JIT 0
+	#endif
+#endif
+
+
+// --- Note ---
+// The VM counts how often each loop header and each function entry is reached. Once
+// one of them gets hot, the code reachable from it is compiled to machine code, under
+// the assumption that the registers read there keep the types they have at that moment.
+// Checking these types is all the compiled code does on entry.
+//
+// From the entry types, the compiler works out the type of every register at every
+// instruction. Only instructions whose operands are then known to be numbers or logic
+// values are compiled. Anything else (a call, a lookup by name, printing, a type which
+// is not certain, a division by zero) leaves the machine code: it returns the position
+// of the instruction, and the VM carries on from there. Registers stay in memory, so the
+// VM always finds them up to date. The budget is charged at every back-edge, and the
+// machine code leaves as well when the current batch runs out.
+
+
+class NativeCode final
+{
+	void* memory = nullptr;
+	size_t size = 0;
+
+public:
+	using Entry = uint32_t (*)(RegisterValue* registers, uint32_t* countdown);
+
+	/// <summary>
+	///	Returned by the code when the registers do not have the types it has been compiled for.
+	/// </summary>
+	static constexpr uint32_t guard_failed = UINT32_MAX;
+
+	/// <summary>
+	///	Copies the machine code into executable memory.
+	/// </summary>
+	explicit NativeCode(const std::vector<uint8_t>& bytes);
+
+	~NativeCode();
+
+	NativeCode(const NativeCode&) = delete;
+	NativeCode(NativeCode&&) = delete;
+
+	auto operator=(const NativeCode&) -> NativeCode& = delete;
+	auto operator=(NativeCode&&) -> NativeCode& = delete;
+
+
+	[[nodiscard]]
+	auto is_valid() const -> bool;
+
+	/// <summary>
+	///	Runs the code on the register window. Returns the position the VM resumes at.
+	/// </summary>
+	auto run(RegisterValue* registers, uint32_t* countdown) const -> uint32_t
+	{
+		return reinterpret_cast<Entry>(memory)(registers, countdown);
+	}
+};
+
+
+class Jit final
+{
+	static constexpr uint32_t hot_threshold = 64;
+	static constexpr uint8_t max_compilations = 4;
+
+	struct HotSpot final
+	{
+		uint32_t heat = 0;
+		uint8_t compilations = 0;
+		std::unique_ptr<NativeCode> code;
+	};
+
+	const BytecodeProgram* program;
+	std::vector<std::vector<HotSpot>> hot_spots;	// Indexed by prototype, then by position.
+
+	auto get_hot_spot(const FunctionPrototype& prototype, uint32_t pc) -> HotSpot&;
+
+	void compile(HotSpot& spot, const FunctionPrototype& prototype, uint32_t pc, const RegisterValue* registers);
+
+	auto run(HotSpot& spot, uint32_t pc, RegisterValue* registers, ExecutionBudget& budget) -> uint32_t;
+
+public:
+	explicit Jit(const BytecodeProgram& program);
+
+	/// <summary>
+	///	Called where the VM reaches a loop header or enters a function. Runs the machine code compiled for the position,
+	///	compiling it first once the position is hot. Returns the position the VM continues at, the given one when nothing ran.
+	/// </summary>
+	auto enter(const FunctionPrototype& prototype, const uint32_t pc, RegisterValue* registers, ExecutionBudget& budget) -> uint32_t
+	{
+		HotSpot& spot = get_hot_spot(prototype, pc);
+
+		if (spot.code == nullptr)
+		{
+			if (spot.compilations == max_compilations || ++spot.heat < hot_threshold) {
+				return pc;
+			}
+
+			compile(spot, prototype, pc, registers);
+
+			if (spot.code == nullptr) {
+				return pc;
+			}
+		}
+
+		return run(spot, pc, registers, budget);
+	}
+};
@@ -1,37 +1,111 @@
 ﻿
 #include "lexing.h"
 
-#include <any>
 #include <iostream>
+#include <string>
+#include <string_view>
 
+#include "stream.h"
 
-auto main() -> int
+
+// Defined by the reentrant scanner flex generates.
+auto yylex_init_extra(LexerUtil* extra, yyscan_t* scanner) -> int;
+void yyset_in(FILE* input, yyscan_t scanner);
+auto yy_scan_bytes(const char* bytes, int length, yyscan_t scanner) -> struct yy_buffer_state*;
+auto yylex_destroy(yyscan_t scanner) -> int;
+
+
+void yyerror(YYLTYPE* location, yyscan_t scanner, ParsingContext& context, const char* message)
+{
+	context.report_error(message);
+}
+
+
+ParsingContext::ParsingContext(FILE* input, Arena& arena)
+	: arena(&arena)
+{
+	yylex_init_extra(&this->lexer_util, &this->scanner);
+	yyset_in(input, this->scanner);
+}
+
+ParsingContext::ParsingContext(const std::string_view source, Arena& arena)
+	: arena(&arena)
+{
+	yylex_init_extra(&this->lexer_util, &this->scanner);
+	yy_scan_bytes(source.data(), static_cast<int>(source.size()), this->scanner);
+}
+
+ParsingContext::ParsingContext(FILE* input, StreamingExecution& streaming)
+	: ParsingContext(input, streaming.get_arena())
+{
+	this->streaming = &streaming;
+}
+
+ParsingContext::~ParsingContext()
+{
+	yylex_destroy(this->scanner);
+}
+
+auto ParsingContext::parse() -> int
 {
-	lu().set_verbose_log(false);
+	return yyparse(this->scanner, *this);
+}
 
-	// Invoke Lexer and Parser
-    const auto parsing_result = yyparse();
+auto ParsingContext::get_lexer_util() -> LexerUtil&
+{
+	return this->lexer_util;
+}
 
-	if (parsing_result != 0) {
-		lu().print_log();
+auto ParsingContext::get_arena() -> Arena&
+{
+	return *this->arena;
+}
+
+auto ParsingContext::get_root() const -> AstRoot*
+{
+	return this->root;
+}
+
+auto ParsingContext::take_top_level_statement(std::vector<StatementNode*>* list, StatementNode* statement) -> std::vector<StatementNode*>*
+{
+	if (this->streaming != nullptr) {
+		this->streaming->execute(*statement);
+		this->arena = &this->streaming->get_arena();
+		return nullptr;
 	}
-	else {
-		std::cout << "Program finished";
+
+	if (list == nullptr) {
+		list = this->arena->make<std::vector<StatementNode*>>();
 	}
 
-	return parsing_result;
+	list->push_back(statement);
+	return list;
 }
 
+void ParsingContext::take_program(std::vector<StatementNode*>* list)
+{
+	if (this->streaming == nullptr) {
+		this->root = this->arena->make<AstRoot>(this->arena->make<BlockNode>(*this->arena, *list));
+	}
+}
+
+void ParsingContext::report_error(const char* message)
+{
+	this->errors.emplace_back(message);
+}
 
-auto lu() -> LexerUtil&
+auto ParsingContext::get_errors() const -> const std::vector<std::string>&
 {
-	static LexerUtil global_instance{};
-	return global_instance;
+	return this->errors;
 }
 
-void yyerror(const char* s)
+void ParsingContext::print_errors() const
 {
-	std::cout << "Error: " << s << '\n';
+	for (const auto& error : this->errors) {
+		std::cout << "Error: " << error << '\n';
+	}
+
+	this->lexer_util.print_log();
 }
 
 
@@ -92,23 +166,14 @@ auto get_token_name(const yytokentype token) -> const char*
 }
 
 
-void LexerUtil::set_verbose_log(const bool v)
+void LexerUtil::set_multiline(const bool v)
 {
-	this->verbose_log = v;
+	this->multiline = v;
 }
 
-auto LexerUtil::feed(const yytokentype token_type, const char* token_value) -> int
+auto LexerUtil::is_multiline() const -> bool
 {
-	if (verbose_log)
-	{
-		std::string msg = (token_value != nullptr)
-			? (std::string(get_token_name(token_type)) + ": " + token_value)
-			: (std::string(get_token_name(token_type)));
-
-		log.emplace_back(std::move(msg));
-	}
-
-	return token_type;
+	return this->multiline;
 }
 
 void LexerUtil::print_log() const
@@ -116,6 +181,33 @@ void LexerUtil::print_log() const
 	for (const auto& msg : log) {
 		std::cout << msg << '\n';
 	}
+
+#if HOMEWORKSCRIPT_LEXER_TRACE
+	if (traced_tokens == 0) {
+		return;
+	}
+
+	std::cout << "Last tokens read:\n";
+
+	const uint64_t first = traced_tokens > trace_capacity ? traced_tokens - trace_capacity : 0;
+
+	for (uint64_t i = first; i < traced_tokens; ++i)
+	{
+		const TokenRecord& record = trace[i % trace_capacity];
+
+		std::cout << "  ";
+
+		// Single characters are tokens of their own.
+		if (record.token > 0 && record.token < 256) {
+			std::cout << '\'' << static_cast<char>(record.token) << '\'';
+		}
+		else {
+			std::cout << get_token_name(static_cast<yytokentype>(record.token));
+		}
+
+		std::cout << " at " << record.offset << ", " << record.length << " characters\n";
+	}
+#endif
 }
 
 
@@ -126,11 +218,6 @@ auto LexerUtil::get_comment_level() const -> int32_t
 
 void LexerUtil::increase_comment_level()
 {
-	if (verbose_log) {
-		std::string msg = "Comment level increased to " + std::to_string(this->comment_level + 1);
-		log.emplace_back(std::move(msg));
-	}
-
 	++this->comment_level;
 }
 
@@ -141,11 +228,6 @@ void LexerUtil::decrease_comment_level()
 		log.emplace_back(std::move(msg));
 	}
 
-	if (verbose_log) {
-		std::string msg = "Comment level decreased to " + std::to_string(this->comment_level - 1);
-		log.emplace_back(std::move(msg));
-	}
-
 	--this->comment_level;
 }
 
@@ -2,7 +2,10 @@
 
 
 // CPP Includes
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // C Includes
@@ -13,33 +16,111 @@
 
 #include "parser.tab.h"
 
+// Project Includes
+#include "arena.h"
+#include "ast.h"
+#include "stream.h"
+
+
+// Compile with HOMEWORKSCRIPT_LEXER_TRACE=0 to leave tracing out of the scanner altogether.
+#ifndef HOMEWORKSCRIPT_LEXER_TRACE
+	#define HOMEWORKSCRIPT_LEXER_TRACE 1
+#endif
+
+
+// --- Note ---
+// A parse keeps all of its state in a ParsingContext: the scanner, the arena the tree
+// is built in, and the lexing log. Nothing is shared between contexts except the
+// symbol table, which is safe to use from many threads, so scripts may be parsed
+// in parallel, each one by its own context.
+//
+// The scanner traces the tokens it hands out into a small ring buffer of fixed-size
+// records. Nothing is formatted while lexing: the records become text only when
+// a syntax error is reported, to show what the parser saw last.
+
 
 /// <summary>
-///	Returns the LexerUtil instance.
+///	Token handed out by the scanner: where it starts in the input and how many characters it spans.
 /// </summary>
-[[nodiscard]] auto lu() -> class LexerUtil&;
+struct TokenRecord final
+{
+	int32_t token;
+	uint32_t offset;
+	uint32_t length;
+};
 
 
+/// <summary>
+///	State of the scanner. Flex hands it to every lexer action.
+/// </summary>
 class LexerUtil final
 {
+	static constexpr size_t trace_capacity = 32;
+
 	int32_t comment_level = 0;
 	std::vector<std::string> log{};
-	bool verbose_log = true;
+	bool multiline = false;
+	int line = 1;
+	int column = 1;
+
+#if HOMEWORKSCRIPT_LEXER_TRACE
+	std::array<TokenRecord, trace_capacity> trace{};
+	uint64_t traced_tokens = 0;
+	uint32_t position = 0;
+	uint32_t token_offset = 0;
+#endif
 
 public:
 	/// <summary>
-	///	Configures if full log is built during lexing.
+	///	Configures if a newline is whitespace. Otherwise it ends the program.
 	/// </summary>
-	void set_verbose_log(bool v);
+	void set_multiline(bool v);
+
+	[[nodiscard]] auto is_multiline() const -> bool;
 
 
 	/// <summary>
 	///	Handles next token.
 	/// </summary>
-	auto feed(yytokentype token_type, const char* token_value = nullptr) -> int;
+	auto feed(const int token_type) -> int
+	{
+#if HOMEWORKSCRIPT_LEXER_TRACE
+		trace[traced_tokens % trace_capacity] = TokenRecord{ token_type, token_offset, position - token_offset };
+		++traced_tokens;
+#endif
+		return token_type;
+	}
+
+	/// <summary>
+	///	Moves past the characters the scanner has just matched, storing where they lie in the location. Runs before every lexer action.
+	/// </summary>
+	void advance(YYLTYPE& location, const char* text, const size_t length)
+	{
+		location.first_line = line;
+		location.first_column = column;
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (text[i] == '\n') {
+				++line;
+				column = 1;
+			}
+			else {
+				++column;
+			}
+		}
+
+		location.last_line = line;
+		location.last_column = column - 1;
+
+#if HOMEWORKSCRIPT_LEXER_TRACE
+		token_offset = position;
+		position += static_cast<uint32_t>(length);
+#endif
+	}
 
 	/// <summary>
-	///	Prints the log to std::cout.
+	///	Prints the log, followed by the last tokens read, to std::cout.
 	/// </summary>
 	void print_log() const;
 
@@ -50,3 +131,81 @@ public:
 
 	void decrease_comment_level();
 };
+
+
+class ParsingContext final
+{
+	LexerUtil lexer_util;
+	yyscan_t scanner = nullptr;
+	Arena* arena;
+	StreamingExecution* streaming = nullptr;
+	AstRoot* root = nullptr;
+	std::vector<std::string> errors;
+
+public:
+	/// <summary>
+	///	Prepares a parse of the input, building the whole tree in the arena.
+	/// </summary>
+	explicit ParsingContext(FILE* input, Arena& arena);
+
+	/// <summary>
+	///	Prepares a parse of the source held in memory, building the whole tree in the arena.
+	/// </summary>
+	explicit ParsingContext(std::string_view source, Arena& arena);
+
+	/// <summary>
+	///	Prepares a parse of the input, handing every top-level statement over to the session.
+	/// </summary>
+	explicit ParsingContext(FILE* input, StreamingExecution& streaming);
+
+	~ParsingContext();
+
+	ParsingContext(const ParsingContext&) = delete;
+	ParsingContext(ParsingContext&&) = delete;
+
+	auto operator=(const ParsingContext&) -> ParsingContext& = delete;
+	auto operator=(ParsingContext&&) -> ParsingContext& = delete;
+
+
+	/// <summary>
+	///	Runs the parser. Returns zero on success, like yyparse.
+	/// </summary>
+	auto parse() -> int;
+
+
+	[[nodiscard]]
+	auto get_lexer_util() -> LexerUtil&;
+
+	/// <summary>
+	///	Returns the arena the next node must be built in.
+	/// </summary>
+	[[nodiscard]]
+	auto get_arena() -> Arena&;
+
+	/// <summary>
+	///	Returns the parsed program. Empty when streaming or when the parse failed.
+	/// </summary>
+	[[nodiscard]]
+	auto get_root() const -> AstRoot*;
+
+
+	/// <summary>
+	///	Collects a top-level statement, or executes it right away when streaming.
+	/// </summary>
+	auto take_top_level_statement(std::vector<StatementNode*>* list, StatementNode* statement) -> std::vector<StatementNode*>*;
+
+	/// <summary>
+	///	Builds the root of the program out of the collected top-level statements.
+	/// </summary>
+	void take_program(std::vector<StatementNode*>* list);
+
+	void report_error(const char* message);
+
+	[[nodiscard]]
+	auto get_errors() const -> const std::vector<std::string>&;
+
+	/// <summary>
+	///	Prints the syntax errors, followed by the lexing log, to std::cout.
+	/// </summary>
+	void print_errors() const;
+};
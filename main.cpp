@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+#include "ast.h"
+#include "cache.h"
+#include "lexing.h"
+#include "memo.h"
+#include "profiler.h"
+#include "stream.h"
+#include "vm.h"
+
+
+enum class ExecutionEngine
+{
+	TreeWalker,
+	Bytecode,
+};
+
+
+// Raised by Ctrl+C. The running program notices it at its next budget check.
+std::atomic<bool> interrupted{ false };
+
+void handle_interrupt(int)
+{
+	interrupted.store(true, std::memory_order_relaxed);
+}
+
+
+// Parses the number following the given option prefix.
+auto parse_option_number(const std::string_view arg, const std::string_view prefix) -> std::optional<uint64_t>
+{
+	if (!arg.starts_with(prefix)) {
+		return std::nullopt;
+	}
+
+	const std::string_view digits = arg.substr(prefix.size());
+	uint64_t number = 0;
+	const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), number);
+
+	if (error != std::errc{} || end != digits.data() + digits.size()) {
+		return std::nullopt;
+	}
+
+	return number;
+}
+
+
+constexpr std::string_view usage =
+	"Usage: HomeworkScript [--engine=ast|--engine=bytecode] [--fuel=N] [--time-limit=MS] [--max-depth=N] [--memo=N] [--memo-stats] [--no-jit] [--stream] [--cache=DIR] [--profile=FILE] < program\n";
+
+
+// Checks the types of the resolved program and prints the errors found. Returns whether it may run.
+auto check_types(AstRoot& root, Arena& program_arena) -> bool
+{
+	const std::vector<std::string> errors = root.check_types(program_arena);
+
+	for (const std::string& error : errors) {
+		std::cout << "Error: " << error << '\n';
+	}
+
+	return errors.empty();
+}
+
+// Reads the compiled program from the cache, or compiles it and stores it there. A cached program
+// has passed the checks of the build which wrote it, and bytecode_version tells that build apart.
+auto load_or_compile(const std::filesystem::path& cache_directory) -> std::optional<BytecodeProgram>
+{
+	const std::string source{ std::istreambuf_iterator<char>{ std::cin }, {} };
+	const std::filesystem::path cache_path = get_cache_path(cache_directory, hash_source(source));
+
+	if (std::optional<BytecodeProgram> cached = load_compiled_program(cache_path, source)) {
+		return cached;
+	}
+
+	Arena program_arena;
+	ParsingContext context{ source, program_arena };
+
+	if (context.parse() != 0) {
+		context.print_errors();
+		return std::nullopt;
+	}
+
+	AstRoot* root = context.get_root();
+	root->fold(program_arena);
+	root->resolve();
+
+	if (!check_types(*root, program_arena)) {
+		return std::nullopt;
+	}
+
+	BytecodeProgram program = compile_to_bytecode(*root);
+	save_compiled_program(program, cache_path, source);
+
+	return program;
+}
+
+
+auto main(const int argc, const char* argv[]) -> int
+{
+	ExecutionEngine engine = ExecutionEngine::TreeWalker;
+	ExecutionLimits limits;
+	limits.cancellation = &interrupted;
+	bool print_memo_statistics = false;
+	bool stream = false;
+	std::optional<std::filesystem::path> cache_directory;
+	std::optional<std::filesystem::path> profile_path;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+
+		if (arg == "--engine=ast") {
+			engine = ExecutionEngine::TreeWalker;
+		}
+		else if (arg == "--engine=bytecode") {
+			engine = ExecutionEngine::Bytecode;
+		}
+		else if (const auto fuel = parse_option_number(arg, "--fuel=")) {
+			limits.fuel = *fuel;
+		}
+		else if (const auto milliseconds = parse_option_number(arg, "--time-limit=")) {
+			limits.time_limit = std::chrono::milliseconds{ *milliseconds };
+		}
+		else if (const auto depth = parse_option_number(arg, "--max-depth=")) {
+			limits.max_call_depth = static_cast<uint32_t>(std::min<uint64_t>(*depth, std::numeric_limits<uint32_t>::max()));
+		}
+		else if (const auto capacity = parse_option_number(arg, "--memo=")) {
+			limits.memo_capacity = static_cast<size_t>(*capacity);
+		}
+		else if (arg == "--memo-stats") {
+			print_memo_statistics = true;
+		}
+		else if (arg == "--no-jit") {
+			limits.jit = false;
+		}
+		else if (arg == "--stream") {
+			stream = true;
+		}
+		else if (arg.starts_with("--cache=") && arg.size() > 8) {
+			cache_directory = std::filesystem::path{ arg.substr(8) };
+		}
+		else if (arg.starts_with("--profile=") && arg.size() > 10) {
+			profile_path = std::filesystem::path{ arg.substr(10) };
+		}
+		else {
+			std::cout << "Unknown option: " << arg << '\n';
+			std::cout << usage;
+			return 1;
+		}
+	}
+
+	if (stream && engine != ExecutionEngine::TreeWalker) {
+		std::cout << "Streaming runs only on the tree walker.\n";
+		std::cout << usage;
+		return 1;
+	}
+
+	if (cache_directory.has_value() && (engine != ExecutionEngine::Bytecode || stream)) {
+		std::cout << "Only the bytecode engine runs cached programs.\n";
+		std::cout << usage;
+		return 1;
+	}
+
+	if (profile_path.has_value() && (engine != ExecutionEngine::TreeWalker || stream)) {
+		std::cout << "Only the tree walker is profiled, and not while streaming.\n";
+		std::cout << usage;
+		return 1;
+	}
+
+	const auto print_statistics = [print_memo_statistics](const MemoStatistics& statistics)
+	{
+		if (print_memo_statistics) {
+			std::cerr << "Memoized calls: " << statistics.hits << " hits, " << statistics.misses << " misses.\n";
+		}
+	};
+
+	std::signal(SIGINT, handle_interrupt);
+
+	if (stream) {
+		// Statements run as they are parsed, each one in an arena of its own.
+		StreamingExecution session{ limits };
+		ParsingContext context{ stdin, session };
+		context.get_lexer_util().set_multiline(true);
+
+		const auto parsing_result = context.parse();
+
+		if (parsing_result != 0) {
+			context.print_errors();
+		}
+		else {
+			session.finish();
+			std::cout << "Program finished";
+		}
+
+		return parsing_result;
+	}
+
+	if (cache_directory.has_value())
+	{
+		const std::optional<BytecodeProgram> program = load_or_compile(*cache_directory);
+
+		if (!program.has_value()) {
+			return 1;
+		}
+
+		print_statistics(execute_program(*program, limits));
+		std::cout << "Program finished";
+		return 0;
+	}
+
+	// The whole parse tree is released at once, together with this arena.
+	Arena program_arena;
+	ParsingContext context{ stdin, program_arena };
+
+	// Invoke Lexer and Parser
+	const auto parsing_result = context.parse();
+
+	if (parsing_result != 0) {
+		context.print_errors();
+	}
+	else {
+		AstRoot* root = context.get_root();
+		root->fold(program_arena);
+		root->resolve();
+
+		if (!check_types(*root, program_arena)) {
+			return 1;
+		}
+
+		MemoStatistics memo_statistics;
+		std::optional<Profiler> profiler;
+
+		if (profile_path.has_value()) {
+			profiler.emplace();
+		}
+
+		switch (engine) {
+			case ExecutionEngine::TreeWalker:
+				memo_statistics = root->execute(limits, profiler.has_value() ? &*profiler : nullptr);
+				break;
+			case ExecutionEngine::Bytecode:
+				memo_statistics = root->execute_bytecode(limits);
+				break;
+		}
+
+		print_statistics(memo_statistics);
+
+		if (profiler.has_value())
+		{
+			profiler->print_report(std::cerr, 20);
+
+			std::ofstream stacks{ *profile_path };
+			profiler->write_collapsed_stacks(stacks);
+
+			if (!stacks) {
+				std::cerr << "Can not write the profile to " << profile_path->string() << ".\n";
+			}
+		}
+
+		std::cout << "Program finished";
+	}
+
+	return parsing_result;
+}
@@ -0,0 +1,111 @@
+#include "memo.h"
+
+#include <functional>
+#include <string>
+
+
+auto hash_value(const Value& value) -> size_t
+{
+	size_t hash = static_cast<size_t>(value.get_type());
+
+	if (const Value::Logic* logic = value.try_get<Value::Logic>()) {
+		hash = hash * 31 + std::hash<Value::Logic>{}(*logic);
+	}
+	else if (const Value::Number* number = value.try_get<Value::Number>()) {
+		hash = hash * 31 + std::hash<Value::Number>{}(*number);
+	}
+	else if (const Value::Text* text = value.try_get<Value::Text>()) {
+		hash = hash * 31 + std::hash<Value::Text>{}(*text);
+	}
+
+	return hash;
+}
+
+auto hash_key(const void* function, const std::span<const Value> inputs) -> size_t
+{
+	size_t hash = std::hash<const void*>{}(function);
+
+	for (const Value& input : inputs) {
+		hash = hash * 31 + hash_value(input);
+	}
+
+	return hash;
+}
+
+
+auto MemoTable::KeyHash::operator()(const Key& key) const -> size_t
+{
+	return hash_key(key.function, key.inputs);
+}
+
+auto MemoTable::KeyHash::operator()(const KeyView& key) const -> size_t
+{
+	return hash_key(key.function, key.inputs);
+}
+
+auto MemoTable::are_equal(const std::span<const Value> left, const std::span<const Value> right) -> bool
+{
+	if (left.size() != right.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < left.size(); ++i)
+	{
+		if (left[i].get_type() != right[i].get_type()) {
+			return false;
+		}
+
+		bool equal = false;
+
+		switch (left[i].get_type()) {
+			case Value::Type::Logic:	equal = *left[i].try_get<Value::Logic>() == *right[i].try_get<Value::Logic>(); break;
+			case Value::Type::Number:	equal = *left[i].try_get<Value::Number>() == *right[i].try_get<Value::Number>(); break;
+			case Value::Type::Text:		equal = *left[i].try_get<Value::Text>() == *right[i].try_get<Value::Text>(); break;
+		}
+
+		if (!equal) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+MemoTable::MemoTable(const size_t capacity)
+	: capacity(capacity)
+{
+}
+
+auto MemoTable::get_probe() -> std::vector<Value>&
+{
+	probe.clear();
+	return probe;
+}
+
+auto MemoTable::find(const void* function, const std::span<const Value> inputs) -> const std::optional<Value>*
+{
+	const auto found = entries.find(KeyView{ function, inputs });
+
+	if (found == entries.end()) {
+		++statistics.misses;
+		return nullptr;
+	}
+
+	++statistics.hits;
+	return &found->second;
+}
+
+void MemoTable::store(const void* function, std::vector<Value> inputs, std::optional<Value> result)
+{
+	if (entries.size() >= capacity) {
+		entries.clear();
+	}
+
+	entries.insert_or_assign(Key{ function, std::move(inputs) }, std::move(result));
+}
+
+auto MemoTable::get_statistics() const -> MemoStatistics
+{
+	return statistics;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+
+
+// --- Note ---
+// A pure function writes nothing outside of its frame, prints nothing and calls
+// only pure functions. Its result is then decided by its inputs: the arguments
+// and the values of the free names it (or anything it calls) reads, which are
+// bound by the caller. The resolver finds such functions, and both engines look
+// their calls up in a MemoTable before running the body. Functions which neither
+// loop nor call are left out: running them is cheaper than the lookup.
+//
+// The table is bounded. Once it is full, it is cleared and starts over, so
+// a long run never holds more than the capacity of results.
+
+
+struct MemoStatistics final
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
+
+class MemoTable final
+{
+	struct Key final
+	{
+		const void* function;
+		std::vector<Value> inputs;
+	};
+
+	struct KeyView final
+	{
+		const void* function;
+		std::span<const Value> inputs;
+	};
+
+	struct KeyHash final
+	{
+		using is_transparent = void;
+
+		auto operator()(const Key& key) const -> size_t;
+		auto operator()(const KeyView& key) const -> size_t;
+	};
+
+	struct KeyEqual final
+	{
+		using is_transparent = void;
+
+		template<typename TLeft, typename TRight>
+		auto operator()(const TLeft& left, const TRight& right) const -> bool
+		{
+			return left.function == right.function && are_equal(left.inputs, right.inputs);
+		}
+	};
+
+	std::unordered_map<Key, std::optional<Value>, KeyHash, KeyEqual> entries;
+	std::vector<Value> probe;
+	size_t capacity;
+	MemoStatistics statistics;
+
+	[[nodiscard]]
+	static auto are_equal(std::span<const Value> left, std::span<const Value> right) -> bool;
+
+public:
+	explicit MemoTable(size_t capacity);
+
+	/// <summary>
+	///	Returns an emptied buffer for gathering the inputs of a call, reused to spare allocations.
+	/// </summary>
+	auto get_probe() -> std::vector<Value>&;
+
+	/// <summary>
+	///	Finds the result of an earlier call of the function with equal inputs. Counts a hit or a miss.
+	/// </summary>
+	auto find(const void* function, std::span<const Value> inputs) -> const std::optional<Value>*;
+
+	void store(const void* function, std::vector<Value> inputs, std::optional<Value> result);
+
+	[[nodiscard]]
+	auto get_statistics() const -> MemoStatistics;
+};
@@ -6,14 +6,46 @@
 #include <string>
 
 #include "parser.tab.h"
+#include "arena.h"
 #include "ast.h"
+#include "lexing.h"
+
+int yylex(YYSTYPE* yylval, YYLTYPE* yylloc, yyscan_t scanner);
+void yyerror(YYLTYPE* location, yyscan_t scanner, ParsingContext& context, const char* message);
+
+// Tags the node with the part of the source it has been parsed from.
+template<typename Node>
+static auto located(Node* node, const YYLTYPE& location) -> Node*
+{
+	node->set_location(SourceRange{
+		static_cast<uint32_t>(location.first_line),
+		static_cast<uint32_t>(location.first_column),
+		static_cast<uint32_t>(location.last_line),
+		static_cast<uint32_t>(location.last_column)
+	});
+
+	return node;
+}
+
+%}
 
-int yylex(void);
-void yyerror(const char *s);
+%code requires {
+#include <vector>
 
-class AstRoot* root;
+#include "symbols.h"
 
-%}
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+class ParsingContext;
+}
+
+// Everything a parse needs is passed in, so separate parses may run on separate threads.
+%define api.pure full
+%param { yyscan_t scanner }
+%parse-param { ParsingContext& context }
 
 %define parse.error detailed
 %locations
@@ -21,24 +53,29 @@ class AstRoot* root;
 %union {
 	int ival;
 	bool bval;
-	char* str;
+	Symbol sym;
 
 	class Node* node;
 	class StatementNode* statement_node;
 	class ExpressionNode* expression_node;
 	class ArgsListNode* args_node;
+	std::vector<class StatementNode*>* statement_list;
+	std::vector<Symbol>* name_list;
 }
 
 %type <statement_node> statement
 %type <statement_node> statements
+%type <statement_list> statement_list
+%type <statement_list> top_level_list
 %type <statement_node> body
 %type <expression_node> expression
 %type <args_node> args_list
+%type <name_list> name_list
 
 
 %token <bval> TRUE FALSE
 %token <ival> NUMBER
-%token <str> IDENTIFIER
+%token <sym> IDENTIFIER
 
 %token STOP
 %token STATEMENT_SEPARATOR BODY_OPEN BODY_CLOSE
@@ -66,63 +103,79 @@ class AstRoot* root;
 %%
 
 program:
-	statements								{ root = new AstRoot($1); /* root->print_to_console(); */ root->execute(); }
+	top_level_list							{ context.take_program($1); /* context.get_root()->print_to_console(); */ }
+	;
+
+// Kept apart from statement_list, so each top-level statement is taken as soon as it is reduced.
+top_level_list:
+	top_level_list statement STATEMENT_SEPARATOR { $$ = context.take_top_level_statement($1, located($2, @2)); }
+	| statement STATEMENT_SEPARATOR			{ $$ = context.take_top_level_statement(nullptr, located($1, @1)); }
 	;
 
 body:
-	BODY_OPEN statements BODY_CLOSE			{ $$ = new BodyNode($2); }
+	BODY_OPEN statements BODY_CLOSE			{ $$ = context.get_arena().make<BodyNode>($2); }
 	;
 
+// The names are collected first, so the node copies them into the arena only once.
 args_list:
-	args_list ',' IDENTIFIER				{ $$ = new ArgsListNode($3, $1); }
-	| IDENTIFIER							{ $$ = new ArgsListNode($1); }
+	name_list								{ $$ = context.get_arena().make<ArgsListNode>(context.get_arena(), *$1); }
+	;
+
+name_list:
+	name_list ',' IDENTIFIER				{ $$ = $1; $$->push_back($3); }
+	| IDENTIFIER							{ $$ = context.get_arena().make<std::vector<Symbol>>(1, $1); }
 	;
 
+// Left recursion keeps the parser stack flat regardless of the number of statements.
 statements:
-	statement STATEMENT_SEPARATOR statements { $$ = new MultiStatementsNode($1, $3); }
-	| statement STATEMENT_SEPARATOR			{ $$ = $1; }
+	statement_list							{ $$ = context.get_arena().make<BlockNode>(context.get_arena(), *$1); }
+	;
+
+statement_list:
+	statement_list statement STATEMENT_SEPARATOR { $$ = $1; $$->push_back(located($2, @2)); }
+	| statement STATEMENT_SEPARATOR			{ $$ = context.get_arena().make<std::vector<StatementNode*>>(1, located($1, @1)); }
 	;
 
 
 statement:
-	IDENTIFIER '(' args_list ')'			{ $$ = new FunctionCallNode($1, $3); }
-	| LET IDENTIFIER ASSIGN expression		{ $$ = new VariableAssignmentNode(str_to_cpp($2), $4, false); }
-	| IDENTIFIER ASSIGN expression			{ $$ = new VariableAssignmentNode(str_to_cpp($1), $3, true); }
-	| IF expression body					{ $$ = new ConditionalStatementNode($2, $3, false); }
-	| WHILE expression body					{ $$ = new ConditionalStatementNode($2, $3, true); }
-	| FUNC IDENTIFIER '(' args_list ')' body { $$ = new FunctionDeclarationNode($2, $6, $4); }
-	| PRINT IDENTIFIER						{ $$ = new PrintNode($2); }
-	| RETURN expression						{ $$ = new ResultNode($2); }
+	IDENTIFIER '(' args_list ')'			{ $$ = context.get_arena().make<FunctionCallNode>($1, $3); }
+	| LET IDENTIFIER ASSIGN expression		{ $$ = context.get_arena().make<VariableAssignmentNode>($2, $4, false); }
+	| IDENTIFIER ASSIGN expression			{ $$ = context.get_arena().make<VariableAssignmentNode>($1, $3, true); }
+	| IF expression body					{ $$ = context.get_arena().make<ConditionalStatementNode>($2, $3, false); }
+	| WHILE expression body					{ $$ = context.get_arena().make<ConditionalStatementNode>($2, $3, true); }
+	| FUNC IDENTIFIER '(' args_list ')' body { $$ = context.get_arena().make<FunctionDeclarationNode>($2, $6, $4); }
+	| PRINT IDENTIFIER						{ $$ = context.get_arena().make<PrintNode>($2); }
+	| RETURN expression						{ $$ = context.get_arena().make<ResultNode>($2); }
 	;
 
 expression:
-	'(' expression ')'						{ $$ = new BraceExpressionNode($2); }
+	'(' expression ')'						{ $$ = context.get_arena().make<BraceExpressionNode>($2); }
 	
-	| expression MULTIPLY expression		{ $$ = new BinaryOperationNode(ArithmeticOperation::Multiplication, $1, $3); }
-	| expression DIVIDE expression			{ $$ = new BinaryOperationNode(ArithmeticOperation::Division, $1, $3); }
-	| expression PLUS expression			{ $$ = new BinaryOperationNode(ArithmeticOperation::Addition, $1, $3); }
-	| expression MINUS expression			{ $$ = new BinaryOperationNode(ArithmeticOperation::Substraction, $1, $3); }
-	| expression MODULO expression			{ $$ = new BinaryOperationNode(ArithmeticOperation::Modulo, $1, $3); }
-
-	| expression EQUAL expression			{ $$ = new BinaryOperationNode(ComparisonOperation::Equality, $1, $3); }
-	| expression NOT_EQUAL expression		{ $$ = new BinaryOperationNode(ComparisonOperation::Inequality, $1, $3); }
-	| expression LESS_THAN expression		{ $$ = new BinaryOperationNode(ComparisonOperation::Less, $1, $3); }
-	| expression MORE_THAN expression		{ $$ = new BinaryOperationNode(ComparisonOperation::More, $1, $3); }
-	| expression LESS_EQUAL expression		{ $$ = new BinaryOperationNode(ComparisonOperation::LessOrEqual, $1, $3); }
-	| expression MORE_EQUAL expression		{ $$ = new BinaryOperationNode(ComparisonOperation::MoreOrEqual, $1, $3); }
-
-	| expression LOGIC_AND expression		{ $$ = new BinaryOperationNode(LogicOperation::And, $1, $3); }
-	| expression LOGIC_OR expression		{ $$ = new BinaryOperationNode(LogicOperation::Or, $1, $3); }
-	| expression LOGIC_XOR expression		{ $$ = new BinaryOperationNode(LogicOperation::Xor, $1, $3); }
+	| expression MULTIPLY expression		{ $$ = context.get_arena().make<BinaryOperationNode>(ArithmeticOperation::Multiplication, $1, $3); }
+	| expression DIVIDE expression			{ $$ = context.get_arena().make<BinaryOperationNode>(ArithmeticOperation::Division, $1, $3); }
+	| expression PLUS expression			{ $$ = context.get_arena().make<BinaryOperationNode>(ArithmeticOperation::Addition, $1, $3); }
+	| expression MINUS expression			{ $$ = context.get_arena().make<BinaryOperationNode>(ArithmeticOperation::Substraction, $1, $3); }
+	| expression MODULO expression			{ $$ = context.get_arena().make<BinaryOperationNode>(ArithmeticOperation::Modulo, $1, $3); }
+
+	| expression EQUAL expression			{ $$ = context.get_arena().make<BinaryOperationNode>(ComparisonOperation::Equality, $1, $3); }
+	| expression NOT_EQUAL expression		{ $$ = context.get_arena().make<BinaryOperationNode>(ComparisonOperation::Inequality, $1, $3); }
+	| expression LESS_THAN expression		{ $$ = context.get_arena().make<BinaryOperationNode>(ComparisonOperation::Less, $1, $3); }
+	| expression MORE_THAN expression		{ $$ = context.get_arena().make<BinaryOperationNode>(ComparisonOperation::More, $1, $3); }
+	| expression LESS_EQUAL expression		{ $$ = context.get_arena().make<BinaryOperationNode>(ComparisonOperation::LessOrEqual, $1, $3); }
+	| expression MORE_EQUAL expression		{ $$ = context.get_arena().make<BinaryOperationNode>(ComparisonOperation::MoreOrEqual, $1, $3); }
+
+	| expression LOGIC_AND expression		{ $$ = context.get_arena().make<BinaryOperationNode>(LogicOperation::And, $1, $3); }
+	| expression LOGIC_OR expression		{ $$ = context.get_arena().make<BinaryOperationNode>(LogicOperation::Or, $1, $3); }
+	| expression LOGIC_XOR expression		{ $$ = context.get_arena().make<BinaryOperationNode>(LogicOperation::Xor, $1, $3); }
 	
-	| LOGIC_NOT expression					{ $$ = new UnaryOperationNode(UnaryOperation::Not, $2); }
-	| MINUS expression						{ $$ = new UnaryOperationNode(UnaryOperation::Negate, $2); }
+	| LOGIC_NOT expression					{ $$ = context.get_arena().make<UnaryOperationNode>(UnaryOperation::Not, $2); }
+	| MINUS expression						{ $$ = context.get_arena().make<UnaryOperationNode>(UnaryOperation::Negate, $2); }
 	
-	| TRUE									{ $$ = new LiteralNode(Value($1)); }
-	| FALSE									{ $$ = new LiteralNode(Value($1)); }
-	| NUMBER								{ $$ = new LiteralNode(Value($1)); }
+	| TRUE									{ $$ = context.get_arena().make<LiteralNode>(Value($1)); }
+	| FALSE									{ $$ = context.get_arena().make<LiteralNode>(Value($1)); }
+	| NUMBER								{ $$ = context.get_arena().make<LiteralNode>(Value($1)); }
 
-	| IDENTIFIER '(' args_list ')'			{ $$ = new FunctionCallNode($1, $3); }
-	| IDENTIFIER							{ $$ = new VariableReferenceNode($1); }
+	| IDENTIFIER '(' args_list ')'			{ $$ = located(context.get_arena().make<FunctionCallNode>($1, $3), @$); }
+	| IDENTIFIER							{ $$ = context.get_arena().make<VariableReferenceNode>($1); }
 	;
 %%
@@ -0,0 +1,123 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+
+auto Profiler::PathKeyHash::operator()(const PathKey& key) const -> size_t
+{
+	return std::hash<const void*>{}(key.node) ^ (static_cast<size_t>(key.parent) * 0x9E3779B97F4A7C15ull);
+}
+
+auto Profiler::get_label(const StatementNode& node) -> std::string
+{
+	const SourceRange& range = node.get_location();
+
+	return node.describe() + " at "
+		+ std::to_string(range.first_line) + ":" + std::to_string(range.first_column) + "-"
+		+ std::to_string(range.last_line) + ":" + std::to_string(range.last_column);
+}
+
+void Profiler::enter(const StatementNode& node)
+{
+	NodeStatistics& node_statistics = statistics[&node];
+	++node_statistics.count;
+
+	// A recursive activation goes back to the path of the outermost one.
+	if (node_statistics.active++ == 0)
+	{
+		const uint32_t parent = active_nodes.empty() ? root_path : active_nodes.back().path;
+		const auto [found, is_new] = path_children.try_emplace(PathKey{ parent, &node }, static_cast<uint32_t>(paths.size()));
+
+		if (is_new) {
+			paths.push_back(PathNode{ &node, parent });
+		}
+
+		node_statistics.active_path = found->second;
+	}
+
+	active_nodes.push_back(ActiveNode{ &node_statistics, node_statistics.active_path, Clock::now() });
+}
+
+void Profiler::leave()
+{
+	const ActiveNode finished = active_nodes.back();
+	active_nodes.pop_back();
+
+	const auto elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - finished.start).count());
+	const uint64_t exclusive = elapsed - std::min(elapsed, finished.children_ns);
+
+	NodeStatistics& node_statistics = *finished.statistics;
+	node_statistics.exclusive_ns += exclusive;
+
+	if (--node_statistics.active == 0) {
+		node_statistics.inclusive_ns += elapsed;
+	}
+
+	paths[finished.path].exclusive_ns += exclusive;
+
+	if (!active_nodes.empty()) {
+		active_nodes.back().children_ns += elapsed;
+	}
+}
+
+void Profiler::print_report(std::ostream& output, const size_t limit) const
+{
+	std::vector<std::pair<const StatementNode*, const NodeStatistics*>> hottest;
+	hottest.reserve(statistics.size());
+
+	for (const auto& [node, node_statistics] : statistics) {
+		hottest.emplace_back(node, &node_statistics);
+	}
+
+	std::sort(hottest.begin(), hottest.end(), [](const auto& left, const auto& right) {
+		return left.second->exclusive_ns > right.second->exclusive_ns;
+	});
+
+	hottest.resize(std::min(hottest.size(), limit));
+
+	output << "Hot spots:\n";
+	output << "  exclusive ms  inclusive ms        count  node\n";
+
+	for (const auto& [node, node_statistics] : hottest)
+	{
+		char numbers[64];
+		std::snprintf(numbers, sizeof(numbers), "%14.3f%14.3f%13llu",
+			static_cast<double>(node_statistics->exclusive_ns) / 1e6,
+			static_cast<double>(node_statistics->inclusive_ns) / 1e6,
+			static_cast<unsigned long long>(node_statistics->count));
+
+		output << numbers << "  " << get_label(*node) << '\n';
+	}
+}
+
+void Profiler::write_collapsed_stacks(std::ostream& output) const
+{
+	std::vector<std::string> labels(paths.size());
+	std::vector<uint32_t> stack;
+
+	for (size_t i = 1; i < paths.size(); ++i) {
+		labels[i] = get_label(*paths[i].node);
+	}
+
+	for (uint32_t i = 1; i < paths.size(); ++i)
+	{
+		if (paths[i].exclusive_ns == 0) {
+			continue;
+		}
+
+		stack.clear();
+
+		for (uint32_t path = i; path != root_path; path = paths[path].parent) {
+			stack.push_back(path);
+		}
+
+		for (auto path = stack.rbegin(); path != stack.rend(); ++path) {
+			output << (path == stack.rbegin() ? "" : ";") << labels[*path];
+		}
+
+		output << ' ' << paths[i].exclusive_ns << '\n';
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+
+
+// --- Note ---
+// The profiler is opt-in and serves the tree walker. Every statement executed by a block
+// and every call made within an expression is timed. The time a node spends running
+// its children is inclusive; what is left after subtracting them is exclusive. Calls
+// of a recursive function count towards the inclusive time once, at the outermost call.
+//
+// Alongside the totals of each node, the profiler keeps a tree of the paths through
+// which nodes have been reached, with the exclusive time spent at the end of each path.
+// Written out one path per line, these are the collapsed stacks flame graphs are drawn from.
+//
+// Recursion is folded: a node reached again while it is still running continues the path
+// of its outermost activation instead of extending the current one. The number of paths
+// is thus bounded by the distinct chains of nodes without repetition, not by the depth
+// of recursion, and the time of every level is attributed to the same frames.
+
+
+class Profiler final
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct NodeStatistics final
+	{
+		uint64_t count = 0;
+		uint64_t inclusive_ns = 0;
+		uint64_t exclusive_ns = 0;
+		uint32_t active = 0;
+		uint32_t active_path = 0;	// Path of the outermost activation, while the node is active.
+	};
+
+	struct PathNode final
+	{
+		const StatementNode* node;
+		uint32_t parent;
+		uint64_t exclusive_ns = 0;
+	};
+
+	struct PathKey final
+	{
+		uint32_t parent;
+		const StatementNode* node;
+
+		auto operator==(const PathKey&) const -> bool = default;
+	};
+
+	struct PathKeyHash final
+	{
+		auto operator()(const PathKey& key) const -> size_t;
+	};
+
+	struct ActiveNode final
+	{
+		NodeStatistics* statistics;
+		uint32_t path;
+		Clock::time_point start;
+		uint64_t children_ns = 0;
+	};
+
+	static constexpr uint32_t root_path = 0;
+
+	std::unordered_map<const StatementNode*, NodeStatistics> statistics;
+	std::vector<PathNode> paths{ PathNode{ nullptr, root_path } };
+	std::unordered_map<PathKey, uint32_t, PathKeyHash> path_children;
+	std::vector<ActiveNode> active_nodes;
+
+	[[nodiscard]]
+	static auto get_label(const StatementNode& node) -> std::string;
+
+public:
+	void enter(const StatementNode& node);
+
+	void leave();
+
+	/// <summary>
+	///	Prints the nodes which took the most exclusive time, hottest first.
+	/// </summary>
+	void print_report(std::ostream& output, size_t limit) const;
+
+	/// <summary>
+	///	Writes one line per path: the nodes separated by semicolons, then the exclusive nanoseconds spent at its end.
+	/// </summary>
+	void write_collapsed_stacks(std::ostream& output) const;
+};
+
+
+/// <summary>
+///	Times the node for as long as the scope lasts. Does nothing without a profiler.
+/// </summary>
+class ProfiledScope final
+{
+	Profiler* profiler;
+
+public:
+	explicit ProfiledScope(Profiler* profiler, const StatementNode& node)
+		: profiler(profiler)
+	{
+		if (profiler != nullptr) {
+			profiler->enter(node);
+		}
+	}
+
+	~ProfiledScope()
+	{
+		if (profiler != nullptr) {
+			profiler->leave();
+		}
+	}
+
+	ProfiledScope(const ProfiledScope&) = delete;
+	ProfiledScope(ProfiledScope&&) = delete;
+
+	auto operator=(const ProfiledScope&) -> ProfiledScope& = delete;
+	auto operator=(ProfiledScope&&) -> ProfiledScope& = delete;
+};
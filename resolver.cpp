@@ -0,0 +1,368 @@
+#include "resolver.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+void Resolver::open_scope()
+{
+	scopes.push_back(Scope{ {}, false });
+}
+
+void Resolver::open_function_scope(const Symbol name, FunctionTraits& traits)
+{
+	scopes.push_back(Scope{ {}, true });
+
+	open_functions.push_back(functions.size());
+	functions.push_back(FunctionFrame{ name, &traits });
+}
+
+void Resolver::close_scope()
+{
+	if (scopes.back().is_function_boundary) {
+		open_functions.pop_back();
+	}
+
+	scopes.pop_back();
+}
+
+auto Resolver::resolve(const Symbol name) -> VariableSlot
+{
+	int32_t depth = 0;
+
+	for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope, ++depth)
+	{
+		const auto found = std::find(scope->variables.begin(), scope->variables.end(), name);
+
+		if (found != scope->variables.end()) {
+			return VariableSlot{ depth, static_cast<int32_t>(found - scope->variables.begin()) };
+		}
+
+		if (scope->is_function_boundary) {
+			break;
+		}
+	}
+
+	dynamic_names.push_back(name);
+
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].free_reads.push_back(name);
+	}
+
+	return VariableSlot{};
+}
+
+auto Resolver::declare(const Symbol name) -> std::optional<VariableSlot>
+{
+	auto& variables = scopes.back().variables;
+
+	if (std::find(variables.begin(), variables.end(), name) != variables.end()) {
+		return std::nullopt;
+	}
+
+	variables.push_back(name);
+
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].declarations.push_back(name);
+	}
+
+	return VariableSlot{ 0, static_cast<int32_t>(variables.size() - 1) };
+}
+
+void Resolver::note_function_declaration()
+{
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].declares_functions = true;
+	}
+}
+
+void Resolver::note_effect()
+{
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].has_effects = true;
+	}
+}
+
+void Resolver::note_loop()
+{
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].has_loops = true;
+	}
+}
+
+void Resolver::note_call(const Symbol name)
+{
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].callees.push_back(name);
+	}
+}
+
+void Resolver::note_tail_call(ResultNode& result)
+{
+	if (!open_functions.empty()) {
+		functions[open_functions.back()].tail_calls.push_back(&result);
+	}
+}
+
+void Resolver::enable_tail_calls()
+{
+	std::sort(dynamic_names.begin(), dynamic_names.end());
+
+	for (const FunctionFrame& function : functions)
+	{
+		const bool is_private = !function.declares_functions && std::none_of(
+			function.declarations.begin(),
+			function.declarations.end(),
+			[this](const Symbol name) -> bool
+			{
+				return std::binary_search(dynamic_names.begin(), dynamic_names.end(), name);
+			}
+		);
+
+		if (!is_private) {
+			continue;
+		}
+
+		for (ResultNode* result : function.tail_calls) {
+			result->enable_tail_call();
+		}
+	}
+}
+
+
+void Resolver::analyse_purity()
+{
+	std::unordered_map<Symbol, std::vector<size_t>> declarations;
+
+	for (size_t i = 0; i < functions.size(); ++i) {
+		declarations[functions[i].name].push_back(i);
+	}
+
+	std::vector<bool> is_pure(functions.size());
+
+	for (size_t i = 0; i < functions.size(); ++i) {
+		is_pure[i] = !functions[i].has_effects;
+	}
+
+	auto pure_callee = [&](const Symbol name) -> std::optional<size_t>
+	{
+		const auto found = declarations.find(name);
+
+		if (found == declarations.end() || found->second.size() != 1 || !is_pure[found->second.front()]) {
+			return std::nullopt;
+		}
+
+		return found->second.front();
+	};
+
+	// Recursive functions start as pure, so the loop only ever takes purity away.
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+
+		for (size_t i = 0; i < functions.size(); ++i)
+		{
+			if (is_pure[i] && !std::all_of(functions[i].callees.begin(), functions[i].callees.end(), [&](const Symbol name) { return pure_callee(name).has_value(); })) {
+				is_pure[i] = false;
+				changed = true;
+			}
+		}
+	}
+
+	// The free reads of callees are inputs as well.
+	std::vector<std::vector<Symbol>> inputs(functions.size());
+
+	for (size_t i = 0; i < functions.size(); ++i) {
+		inputs[i] = functions[i].free_reads;
+	}
+
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+
+		for (size_t i = 0; i < functions.size(); ++i)
+		{
+			if (!is_pure[i]) {
+				continue;
+			}
+
+			const size_t before = inputs[i].size();
+
+			for (const Symbol callee : functions[i].callees) {
+				const std::vector<Symbol>& callee_inputs = inputs[*pure_callee(callee)];
+				inputs[i].insert(inputs[i].end(), callee_inputs.begin(), callee_inputs.end());
+			}
+
+			std::sort(inputs[i].begin(), inputs[i].end());
+			inputs[i].erase(std::unique(inputs[i].begin(), inputs[i].end()), inputs[i].end());
+
+			changed = changed || inputs[i].size() != before;
+		}
+	}
+
+	for (size_t i = 0; i < functions.size(); ++i)
+	{
+		functions[i].traits->is_pure = is_pure[i];
+		functions[i].traits->is_memoized = is_pure[i] && (functions[i].has_loops || !functions[i].callees.empty());
+		functions[i].traits->free_reads = is_pure[i] ? std::move(inputs[i]) : std::vector<Symbol>{};
+	}
+}
+
+void Resolver::forget_recorded_functions()
+{
+	functions.clear();
+	dynamic_names.clear();
+}
+
+
+void AstRoot::resolve()
+{
+	Resolver resolver;
+	resolver.open_scope();
+	this->head_statement->resolve(resolver);
+	resolver.close_scope();
+
+	resolver.enable_tail_calls();
+	resolver.analyse_purity();
+}
+
+
+void BraceExpressionNode::resolve(Resolver& resolver)
+{
+	this->braced_expression->resolve(resolver);
+}
+
+void LiteralNode::resolve(Resolver& resolver)
+{
+}
+
+void UnaryOperationNode::resolve(Resolver& resolver)
+{
+	this->child->resolve(resolver);
+}
+
+void BinaryOperationNode::resolve(Resolver& resolver)
+{
+	this->left_child->resolve(resolver);
+	this->right_child->resolve(resolver);
+}
+
+void VariableReferenceNode::resolve(Resolver& resolver)
+{
+	this->slot = resolver.resolve(this->name);
+}
+
+void TypedBinaryOperationNode::resolve(Resolver& resolver)
+{
+	this->left_child->resolve(resolver);
+	this->right_child->resolve(resolver);
+}
+
+void TypedUnaryOperationNode::resolve(Resolver& resolver)
+{
+	this->child->resolve(resolver);
+}
+
+
+void BlockNode::resolve(Resolver& resolver)
+{
+	for (StatementNode* statement : this->statements) {
+		statement->resolve(resolver);
+	}
+}
+
+void BodyNode::resolve(Resolver& resolver)
+{
+	this->body_statement->resolve(resolver);
+}
+
+void ResultNode::resolve(Resolver& resolver)
+{
+	this->result_expression->resolve(resolver);
+
+	if (this->result_expression->try_get_call() != nullptr) {
+		resolver.note_tail_call(*this);
+	}
+}
+
+void VariableAssignmentNode::resolve(Resolver& resolver)
+{
+	// The value is evaluated before the new variable exists.
+	this->expression->resolve(resolver);
+
+	if (this->is_reassignment) {
+		this->slot = resolver.resolve(this->variable_name);
+
+		// Writes to a variable of the caller.
+		if (this->slot.is_dynamic()) {
+			resolver.note_effect();
+		}
+
+		return;
+	}
+
+	const std::optional<VariableSlot> declared = resolver.declare(this->variable_name);
+	this->is_redeclaration = !declared.has_value();
+	this->slot = declared.value_or(VariableSlot{});
+}
+
+void ConditionalStatementNode::resolve(Resolver& resolver)
+{
+	this->condition->resolve(resolver);
+
+	if (this->repeating) {
+		resolver.note_loop();
+	}
+
+	resolver.open_scope();
+	this->statement->resolve(resolver);
+	resolver.close_scope();
+}
+
+void IncrementNode::resolve(Resolver& resolver)
+{
+	this->slot = resolver.resolve(this->variable_name);
+
+	// Writes to a variable of the caller.
+	if (this->slot.is_dynamic()) {
+		resolver.note_effect();
+	}
+}
+
+void ComparisonLoopNode::resolve(Resolver& resolver)
+{
+	// Resolves the variables of the condition too, which the operands share.
+	this->loop->resolve(resolver);
+}
+
+void FunctionDeclarationNode::resolve(Resolver& resolver)
+{
+	resolver.note_function_declaration();
+	resolver.open_function_scope(this->name, this->traits);
+
+	for (const Symbol parameter : this->args->get_list()) {
+		resolver.declare(parameter);
+	}
+
+	this->body->resolve(resolver);
+	resolver.close_scope();
+}
+
+void FunctionCallNode::resolve(Resolver& resolver)
+{
+	this->args->resolve(resolver);
+	resolver.note_call(this->name);
+}
+
+void ArgsListNode::resolve(Resolver& resolver)
+{
+	for (size_t i = 0; i < this->list.size(); ++i) {
+		this->slots[i] = resolver.resolve(this->list[i]);
+	}
+}
+
+void PrintNode::resolve(Resolver& resolver)
+{
+	this->slot = resolver.resolve(this->name);
+	resolver.note_effect();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "ast.h"
+
+
+// --- Note ---
+// The resolver mirrors the scopes the tree walker creates at runtime: one for the program,
+// one for every function call and one for every execution of an if/while body.
+// Variables are appended to a scope in the order of their declarations, so the position
+// of each one is known before the program starts.
+//
+// A function body sees the scopes of its caller, not of its declaration. The resolver
+// stops at the function boundary and leaves the remaining names to the runtime lookup.
+//
+// A frame is private when none of its names is ever left to the runtime lookup and it
+// declares no functions: nothing can find it by name. Only then a returned call may
+// replace the frame, which is decided once the whole program has been seen.
+//
+// Purity is decided at the end as well. Calls go by name, so a call keeps the caller
+// pure only when the name has a single declaration in the program, and it is pure.
+
+
+class Resolver final
+{
+	struct Scope final
+	{
+		std::vector<Symbol> variables;
+		bool is_function_boundary;
+	};
+
+	struct FunctionFrame final
+	{
+		Symbol name;
+		FunctionTraits* traits;
+		std::vector<Symbol> declarations;
+		std::vector<Symbol> free_reads;
+		std::vector<Symbol> callees;
+		std::vector<ResultNode*> tail_calls;
+		bool declares_functions = false;
+		bool has_effects = false;
+		bool has_loops = false;
+	};
+
+	std::vector<Scope> scopes;
+	std::vector<FunctionFrame> functions;
+	std::vector<size_t> open_functions;
+	std::vector<Symbol> dynamic_names;
+
+public:
+	void open_scope();
+
+	/// <summary>
+	///	Opens the scope of a function body. The traits are filled in once the whole program is resolved.
+	/// </summary>
+	void open_function_scope(Symbol name, FunctionTraits& traits);
+
+	void close_scope();
+
+	/// <summary>
+	///	Finds the variable visible at this point. Returns a dynamic slot when the name is left to the runtime.
+	/// </summary>
+	[[nodiscard]]
+	auto resolve(Symbol name) -> VariableSlot;
+
+	/// <summary>
+	///	Adds the variable to the innermost scope. Returns nothing when the scope already has it.
+	/// </summary>
+	auto declare(Symbol name) -> std::optional<VariableSlot>;
+
+	void note_function_declaration();
+
+	/// <summary>
+	///	Records something the innermost function does beyond computing its result, like printing.
+	/// </summary>
+	void note_effect();
+
+	void note_call(Symbol name);
+
+	void note_loop();
+
+	/// <summary>
+	///	Remembers a `return f(...)` of the innermost function, to be enabled if its frame turns out private.
+	/// </summary>
+	void note_tail_call(ResultNode& result);
+
+	/// <summary>
+	///	Enables the tail calls of private frames. Runs after the whole program has been resolved.
+	/// </summary>
+	void enable_tail_calls();
+
+	/// <summary>
+	///	Finds pure functions and their inputs. Runs after the whole program has been resolved.
+	/// </summary>
+	void analyse_purity();
+
+	/// <summary>
+	///	Drops what has been recorded for the analyses above, when the program is resolved piece by piece and they never run.
+	/// </summary>
+	void forget_recorded_functions();
+};
@@ -0,0 +1,61 @@
+#include "script.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lexing.h"
+#include "symbols.h"
+
+
+CompiledScript::CompiledScript(std::unique_ptr<Arena> arena, AstRoot* root)
+	: arena(std::move(arena))
+	, root(root)
+{
+}
+
+auto CompiledScript::compile(const std::string_view source) -> CompiledScript
+{
+	auto arena = std::make_unique<Arena>();
+
+	ParsingContext context{ source, *arena };
+	context.get_lexer_util().set_multiline(true);
+
+	if (context.parse() != 0) {
+		std::string message = "Script can not be compiled.";
+
+		for (const auto& error : context.get_errors()) {
+			message += "\n" + error;
+		}
+
+		throw std::runtime_error(message);
+	}
+
+	AstRoot* root = context.get_root();
+	root->fold(*arena);
+	root->resolve();
+
+	if (const std::vector<std::string> errors = root->check_types(*arena); !errors.empty()) {
+		std::string message = "Script can not be compiled.";
+
+		for (const auto& error : errors) {
+			message += "\n" + error;
+		}
+
+		throw std::runtime_error(message);
+	}
+
+	return CompiledScript{ std::move(arena), root };
+}
+
+auto CompiledScript::run(const std::span<const ScriptInput> inputs, const ExecutionLimits& limits) const -> std::optional<Value>
+{
+	std::vector<Variable> variables;
+	variables.reserve(inputs.size());
+
+	for (const ScriptInput& input : inputs) {
+		variables.emplace_back(symbols().intern(input.name), input.value);
+	}
+
+	return this->root->run(limits, variables);
+}
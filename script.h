@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "arena.h"
+#include "ast.h"
+#include "budget.h"
+
+
+// --- Note ---
+// The entry point for programs embedding the interpreter. A script is lexed, parsed,
+// folded and resolved once, when it is compiled, and may then be run any number of
+// times. Every run starts from scratch: nothing a run declares survives it.
+//
+// Inputs of a run are variables of a scope enclosing the program. The program reads
+// them like any outer variable and may reassign them, which affects only that run.
+// Runs execute on the tree walker and report failures by throwing std::runtime_error.
+//
+// A run is const only towards the program: its nodes keep learning while they execute
+// (operand types, positions of names found on the stack), and that state is written
+// without synchronisation. One compiled script must therefore not be run from several
+// threads at once. Different scripts may be compiled and run in parallel freely.
+
+
+/// <summary>
+///	Variable handed to a run of a script.
+/// </summary>
+struct ScriptInput final
+{
+	std::string_view name;
+	Value value;
+};
+
+
+class CompiledScript final
+{
+	std::unique_ptr<Arena> arena;
+	AstRoot* root;
+
+	explicit CompiledScript(std::unique_ptr<Arena> arena, AstRoot* root);
+
+public:
+	/// <summary>
+	///	Compiles the whole source, newlines included. Throws std::runtime_error listing the syntax errors.
+	/// </summary>
+	[[nodiscard]]
+	static auto compile(std::string_view source) -> CompiledScript;
+
+
+	/// <summary>
+	///	Executes the script with the inputs. Returns the value of the top-level return, if any.
+	///	Must not be called while another run of the same script is in progress on another thread.
+	/// </summary>
+	auto run(std::span<const ScriptInput> inputs, const ExecutionLimits& limits = ExecutionLimits{}) const -> std::optional<Value>;
+};
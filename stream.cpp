@@ -0,0 +1,56 @@
+#include "stream.h"
+
+#include "folding.h"
+
+
+StreamingExecution::StreamingExecution(const ExecutionLimits& limits)
+	: budget(AstRoot::get_tree_walker_limits(limits))
+	, global_state(stack, budget, nullptr, nullptr, &result)
+	, statement_arena(std::make_unique<Arena>())
+{
+	resolver.open_scope();
+}
+
+StreamingExecution::~StreamingExecution()
+{
+	resolver.close_scope();
+}
+
+auto StreamingExecution::get_arena() -> Arena&
+{
+	return *this->statement_arena;
+}
+
+void StreamingExecution::execute(StatementNode& statement)
+{
+	if (has_returned) {
+		statement_arena->reset();
+		return;
+	}
+
+	const size_t functions_before = stack.functions.size();
+
+	Folder folder{ *statement_arena };
+
+	if (StatementNode* folded = statement.fold_statement(folder))
+	{
+		folded->resolve(resolver);
+		resolver.forget_recorded_functions();
+
+		has_returned = folded->execute(global_state) == Completion::Return;
+	}
+
+	if (stack.functions.size() != functions_before) {
+		retained_arenas.push_back(std::move(statement_arena));
+		statement_arena = std::make_unique<Arena>();
+	}
+	else {
+		statement_arena->reset();
+	}
+}
+
+void StreamingExecution::finish()
+{
+	AstRoot::print_result(result);
+	global_state.print_summary();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "arena.h"
+#include "ast.h"
+#include "budget.h"
+#include "resolver.h"
+
+
+// --- Note ---
+// Streaming executes a program while it is still being read. The parser hands over
+// every top-level statement as soon as it is reduced. The statement is folded, resolved
+// against the global scope which stays open for the whole session, and executed at once.
+//
+// Each statement is built in its own arena, which is cleared right after the statement
+// has run, so memory stays flat however long the script is. A statement which leaves
+// a function in the global scope keeps its arena alive: the body is still needed.
+//
+// Tail calls and memoization are decided by looking at the whole program. A stream is
+// never seen whole, so both stay disabled.
+
+
+class StreamingExecution final
+{
+	bool has_returned = false;	// A top-level return ends the program, the rest of the stream is skipped.
+	std::optional<Value> result;
+	ValueStack stack;
+	ExecutionBudget budget;
+	ExecutionScopedState global_state;
+	Resolver resolver;
+
+	std::unique_ptr<Arena> statement_arena;
+	std::vector<std::unique_ptr<Arena>> retained_arenas;
+
+public:
+	explicit StreamingExecution(const ExecutionLimits& limits);
+
+	~StreamingExecution();
+
+	StreamingExecution(const StreamingExecution&) = delete;
+	StreamingExecution(StreamingExecution&&) = delete;
+
+	auto operator=(const StreamingExecution&) -> StreamingExecution& = delete;
+	auto operator=(StreamingExecution&&) -> StreamingExecution& = delete;
+
+
+	/// <summary>
+	///	Returns the arena the parser must build the next statement in.
+	/// </summary>
+	[[nodiscard]]
+	auto get_arena() -> Arena&;
+
+	/// <summary>
+	///	Executes a top-level statement built in the current arena. Statements after a top-level return are skipped.
+	/// </summary>
+	void execute(StatementNode& statement);
+
+	/// <summary>
+	///	Prints the result and the global variables, like the end of a regular execution.
+	/// </summary>
+	void finish();
+};
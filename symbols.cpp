@@ -0,0 +1,42 @@
+#include "symbols.h"
+
+#include <mutex>
+
+
+auto symbols() -> SymbolTable&
+{
+	static SymbolTable global_instance{};
+	return global_instance;
+}
+
+
+auto SymbolTable::intern(const std::string_view name) -> Symbol
+{
+	{
+		std::shared_lock lock{ mutex };
+		const auto found = ids.find(name);
+
+		if (found != ids.end()) {
+			return found->second;
+		}
+	}
+
+	std::unique_lock lock{ mutex };
+
+	// Another thread may have registered the name in the meantime.
+	if (const auto found = ids.find(name); found != ids.end()) {
+		return found->second;
+	}
+
+	const auto symbol = static_cast<Symbol>(names.size());
+	const std::string_view stored = names.emplace_back(storage.copy_string(name));
+	ids.emplace(stored, symbol);
+
+	return symbol;
+}
+
+auto SymbolTable::get_name(const Symbol symbol) const -> std::string_view
+{
+	std::shared_lock lock{ mutex };
+	return names.at(symbol);
+}
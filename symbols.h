@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+
+
+/// <summary>
+///	Compact identifier of an interned name. Equal names always have equal symbols.
+/// </summary>
+using Symbol = uint32_t;
+
+
+/// <summary>
+///	Returns the process-wide SymbolTable instance.
+/// </summary>
+[[nodiscard]] auto symbols() -> class SymbolTable&;
+
+
+// Safe to use from many threads: parses running in parallel intern into the same table.
+class SymbolTable final
+{
+	// Characters of all names live in the arena, so the views never dangle.
+	Arena storage;
+	std::vector<std::string_view> names;
+	std::unordered_map<std::string_view, Symbol> ids;
+	mutable std::shared_mutex mutex;
+
+public:
+	/// <summary>
+	///	Returns the symbol of the name, registering it on first use.
+	/// </summary>
+	auto intern(std::string_view name) -> Symbol;
+
+	[[nodiscard]]
+	auto get_name(Symbol symbol) const -> std::string_view;
+};
@@ -0,0 +1,49 @@
+# Runs a program on the tree walker, on the bytecode VM alone and on the VM with the JIT,
+# and fails unless all three print the same output and end the same way.
+#
+#   cmake -DINTERPRETER=<executable> -DPROGRAM=<file> [-DLAST_LINE=ON] -P compare_engines.cmake
+#
+# The interpreter reads the program from a single line. With LAST_LINE, only the last line
+# of the file is run, for examples which end with the one-line form of the program.
+
+if(NOT INTERPRETER OR NOT PROGRAM)
+  message(FATAL_ERROR "INTERPRETER and PROGRAM must be set.")
+endif()
+
+file(READ "${PROGRAM}" source)
+if(LAST_LINE)
+  string(REGEX MATCH "[^\r\n]+[\r\n]*$" source "${source}")
+endif()
+
+get_filename_component(name "${PROGRAM}" NAME)
+set(input "${CMAKE_CURRENT_BINARY_DIR}/${name}.input")
+file(WRITE "${input}" "${source}")
+
+set(engines ast vm jit)
+set(ast_flags --engine=ast)
+set(vm_flags --engine=bytecode --no-jit)
+set(jit_flags --engine=bytecode)
+
+foreach(engine IN LISTS engines)
+  execute_process(
+    COMMAND "${INTERPRETER}" ${${engine}_flags}
+    INPUT_FILE "${input}"
+    OUTPUT_VARIABLE ${engine}_output
+    RESULT_VARIABLE ${engine}_result
+    ERROR_QUIET
+    TIMEOUT 60)
+endforeach()
+
+# A program rejected before it runs would agree everywhere without testing anything.
+if(ast_output STREQUAL "" OR ast_output MATCHES "^Error:")
+  message(FATAL_ERROR "${name} did not run:\n${ast_output}")
+endif()
+
+foreach(engine vm jit)
+  if(NOT ${engine}_output STREQUAL ast_output OR NOT ${engine}_result STREQUAL ast_result)
+    message(FATAL_ERROR
+      "${name} differs between the tree walker and ${engine}.\n"
+      "--- ast (${ast_result})\n${ast_output}\n"
+      "--- ${engine} (${${engine}_result})\n${${engine}_output}")
+  endif()
+endforeach()
@@ -0,0 +1,349 @@
+#include "typing.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+
+
+TypeChecker::TypeChecker(Arena& arena)
+	: arena(arena)
+{
+}
+
+auto TypeChecker::get_arena() -> Arena&
+{
+	return this->arena;
+}
+
+void TypeChecker::open_scope()
+{
+	scopes.emplace_back();
+}
+
+void TypeChecker::close_scope()
+{
+	scopes.pop_back();
+}
+
+void TypeChecker::declare(const Symbol name, const StaticType type)
+{
+	auto& variables = scopes.back();
+
+	const bool is_declared = std::any_of(variables.begin(), variables.end(), [name](const auto& variable) {
+		return variable.first == name;
+	});
+
+	if (!is_declared) {
+		variables.emplace_back(name, type);
+	}
+}
+
+auto TypeChecker::get_type(const VariableSlot slot) const -> StaticType
+{
+	if (slot.is_dynamic()) {
+		return std::nullopt;
+	}
+
+	return scopes[scopes.size() - 1 - slot.depth][slot.index].second;
+}
+
+void TypeChecker::set_location(const SourceRange& range)
+{
+	this->location = range;
+}
+
+void TypeChecker::report(const std::string& message)
+{
+	if (location.first_line == 0) {
+		errors.push_back(message);
+		return;
+	}
+
+	errors.push_back(std::to_string(location.first_line) + ":" + std::to_string(location.first_column) + ": " + message);
+}
+
+auto TypeChecker::get_errors() -> std::vector<std::string>&
+{
+	return this->errors;
+}
+
+
+namespace TypeRules
+{
+	constexpr Value::Type logic = Value::Type::Logic;
+	constexpr Value::Type number = Value::Type::Number;
+
+	// Finds the type of the result, or reports why the operation can not succeed. The type of a failed
+	// operation is left unknown, so that the error is not reported again by the operations around it.
+	struct BinaryOperationRule final
+	{
+		StaticType left;
+		StaticType right;
+		TypeChecker* checker;
+
+		auto fail(const char* message) const -> StaticType
+		{
+			checker->report(message);
+			return std::nullopt;
+		}
+
+		auto operator()(ArithmeticOperation) const -> StaticType
+		{
+			if (left.has_value() && *left != number) {
+				return fail("Left operand must a number to execute arithmetic operation.");
+			}
+
+			if (right.has_value() && *right != number) {
+				return fail("Right operand must a number to execute arithmetic operation.");
+			}
+
+			return number;
+		}
+
+		auto operator()(LogicOperation) const -> StaticType
+		{
+			if (left.has_value() && *left != logic) {
+				return fail("Left operand must a boolean to execute arithmetic operation.");
+			}
+
+			if (right.has_value() && *right != logic) {
+				return fail("Right operand must a boolean to execute arithmetic operation.");
+			}
+
+			return logic;
+		}
+
+		auto operator()(const ComparisonOperation operation) const -> StaticType
+		{
+			const bool is_equality = operation == ComparisonOperation::Equality || operation == ComparisonOperation::Inequality;
+
+			if (!left.has_value())
+			{
+				if (right.has_value() && *right != number && *right != logic) {
+					return fail("The type can not be a subject of comparison operator.");
+				}
+
+				return logic;
+			}
+
+			if (*left == logic)
+			{
+				if (right.has_value() && *right != logic) {
+					return fail("Logic value must be compared with other logic value.");
+				}
+
+				if (!is_equality) {
+					return fail("Logic value may not be a subject of this comparison operation.");
+				}
+
+				return logic;
+			}
+
+			if (*left == number)
+			{
+				if (right.has_value() && *right != number) {
+					return fail("Number value must be compared with other number value.");
+				}
+
+				return logic;
+			}
+
+			return fail("The type can not be a subject of comparison operator.");
+		}
+	};
+}
+
+
+auto BraceExpressionNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	return this->braced_expression->infer_expression(checker);
+}
+
+auto LiteralNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	return { this, this->value.get_type() };
+}
+
+auto UnaryOperationNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	const InferredExpression operand = this->child->infer_expression(checker);
+	this->child = operand.node;
+
+	const Value::Type expected = operator_ == UnaryOperation::Not ? Value::Type::Logic : Value::Type::Number;
+
+	if (!operand.type.has_value()) {
+		return { this, expected };
+	}
+
+	if (*operand.type != expected) {
+		checker.report(operator_ == UnaryOperation::Not
+			? "Negation with NOT can be done only on logic values."
+			: "Negation with a minus can be done only on numbers!");
+
+		return { this, std::nullopt };
+	}
+
+	return { checker.get_arena().make<TypedUnaryOperationNode>(operator_, this->child), expected };
+}
+
+auto BinaryOperationNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	const InferredExpression left = this->left_child->infer_expression(checker);
+	const InferredExpression right = this->right_child->infer_expression(checker);
+	this->left_child = left.node;
+	this->right_child = right.node;
+
+	const StaticType type = std::visit(TypeRules::BinaryOperationRule{ left.type, right.type, &checker }, this->operation_);
+
+	// Known operand types which pass the rules are the same on both sides.
+	const std::optional<TypedOperation> typed = type.has_value() && left.type.has_value() && right.type.has_value()
+		? this->get_typed_operation(*left.type)
+		: std::nullopt;
+
+	if (!typed.has_value()) {
+		return { this, type };
+	}
+
+	return { checker.get_arena().make<TypedBinaryOperationNode>(*typed, this->left_child, this->right_child), type };
+}
+
+auto VariableReferenceNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	return { this, checker.get_type(this->slot) };
+}
+
+auto FunctionCallNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	return { this, std::nullopt };
+}
+
+auto TypedBinaryOperationNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	return { this, operation < TypedOperation::NumberEquality ? Value::Type::Number : Value::Type::Logic };
+}
+
+auto TypedUnaryOperationNode::infer_expression(TypeChecker& checker) -> InferredExpression
+{
+	return { this, operation == UnaryOperation::Not ? Value::Type::Logic : Value::Type::Number };
+}
+
+
+void BlockNode::check_types(TypeChecker& checker)
+{
+	for (StatementNode* statement : this->statements) {
+		checker.set_location(statement->get_location());
+		statement->check_types(checker);
+	}
+}
+
+void BodyNode::check_types(TypeChecker& checker)
+{
+	this->body_statement->check_types(checker);
+}
+
+void ResultNode::check_types(TypeChecker& checker)
+{
+	// A returned call stays as it is, it may have been chosen for a tail call.
+	this->result_expression = this->result_expression->infer_expression(checker).node;
+}
+
+void VariableAssignmentNode::check_types(TypeChecker& checker)
+{
+	const InferredExpression value = this->expression->infer_expression(checker);
+	this->expression = value.node;
+
+	if (!this->is_reassignment)
+	{
+		if (!this->is_redeclaration) {
+			checker.declare(this->variable_name, value.type);
+		}
+
+		return;
+	}
+
+	const StaticType variable_type = checker.get_type(this->slot);
+
+	if (!variable_type.has_value() || !value.type.has_value()) {
+		return;
+	}
+
+	if (*variable_type != *value.type) {
+		checker.report("Variable type can not be changed.");
+		return;
+	}
+
+	this->is_type_checked = true;
+}
+
+void ConditionalStatementNode::check_types(TypeChecker& checker)
+{
+	const InferredExpression condition_value = this->condition->infer_expression(checker);
+	this->condition = condition_value.node;
+
+	if (condition_value.type.has_value())
+	{
+		if (*condition_value.type != Value::Type::Logic) {
+			checker.report("Expression does not evaluate to boolean.");
+		}
+		else {
+			this->is_condition_checked = true;
+		}
+	}
+
+	checker.open_scope();
+	this->statement->check_types(checker);
+	checker.close_scope();
+}
+
+void IncrementNode::check_types(TypeChecker& checker)
+{
+	const StaticType variable_type = checker.get_type(this->slot);
+
+	if (!variable_type.has_value()) {
+		return;
+	}
+
+	if (*variable_type != Value::Type::Number) {
+		checker.report("Left operand must a number to execute arithmetic operation.");
+		return;
+	}
+
+	this->is_type_checked = true;
+}
+
+void ComparisonLoopNode::check_types(TypeChecker& checker)
+{
+	this->loop->check_types(checker);
+}
+
+void FunctionDeclarationNode::check_types(TypeChecker& checker)
+{
+	checker.open_scope();
+
+	// Parameters take whatever the callers pass.
+	for (const Symbol parameter : this->args->get_list()) {
+		checker.declare(parameter, std::nullopt);
+	}
+
+	this->body->check_types(checker);
+	checker.close_scope();
+}
+
+void FunctionCallNode::check_types(TypeChecker& checker)
+{
+}
+
+void PrintNode::check_types(TypeChecker& checker)
+{
+}
+
+
+auto AstRoot::check_types(Arena& arena) -> std::vector<std::string>
+{
+	TypeChecker checker{ arena };
+	checker.open_scope();
+	this->head_statement->check_types(checker);
+	checker.close_scope();
+
+	return std::move(checker.get_errors());
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "ast.h"
+
+
+// --- Note ---
+// The type of a variable is fixed by its declaration: a reassignment of another type
+// fails. Type checking runs once, after resolving, and follows the scopes the resolver
+// has laid out, so the type of every variable bound to a slot is the type its
+// initializer was found to have. Parameters, names left to the runtime lookup and
+// results of calls are not known until execution.
+//
+// An operation whose operand types are known and fit is replaced by a typed node,
+// which computes its result without looking at the types again. Conditions and
+// reassignments known to be correct skip their checks as well. An operation known
+// to fail whenever it is reached is reported as an error, and the program is not run.
+
+
+class TypeChecker final
+{
+	Arena& arena;
+	std::vector<std::vector<std::pair<Symbol, StaticType>>> scopes;
+	SourceRange location;
+	std::vector<std::string> errors;
+
+public:
+	explicit TypeChecker(Arena& arena);
+
+
+	[[nodiscard]]
+	auto get_arena() -> Arena&;
+
+	void open_scope();
+
+	void close_scope();
+
+	/// <summary>
+	///	Adds the variable to the innermost scope, unless it already has it. Mirrors Resolver::declare.
+	/// </summary>
+	void declare(Symbol name, StaticType type);
+
+	/// <summary>
+	///	Returns the type of the variable in the slot. Nothing is known about dynamic slots.
+	/// </summary>
+	[[nodiscard]]
+	auto get_type(VariableSlot slot) const -> StaticType;
+
+
+	/// <summary>
+	///	Sets the statement which errors are reported at.
+	/// </summary>
+	void set_location(const SourceRange& range);
+
+	void report(const std::string& message);
+
+	[[nodiscard]]
+	auto get_errors() -> std::vector<std::string>&;
+};
@@ -0,0 +1,650 @@
+#include "vm.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+namespace VmOperations
+{
+	auto make_logic(const bool value) -> RegisterValue
+	{
+		return RegisterValue{ RegisterType::Logic, value ? 1 : 0 };
+	}
+
+	auto make_number(const int32_t value) -> RegisterValue
+	{
+		return RegisterValue{ RegisterType::Number, value };
+	}
+
+	auto are_numbers(const RegisterValue& left, const RegisterValue& right) -> bool
+	{
+		return left.type == RegisterType::Number && right.type == RegisterType::Number;
+	}
+
+	auto are_logic(const RegisterValue& left, const RegisterValue& right) -> bool
+	{
+		return left.type == RegisterType::Logic && right.type == RegisterType::Logic;
+	}
+
+	[[noreturn]]
+	void arithmetic_failure(const RegisterValue& left)
+	{
+		if (left.type != RegisterType::Number) {
+			terminate_illegal_program("Left operand must a number to execute arithmetic operation.");
+		}
+
+		terminate_illegal_program("Right operand must a number to execute arithmetic operation.");
+	}
+
+	[[noreturn]]
+	void logic_failure(const RegisterValue& left)
+	{
+		if (left.type != RegisterType::Logic) {
+			terminate_illegal_program("Left operand must a boolean to execute arithmetic operation.");
+		}
+
+		terminate_illegal_program("Right operand must a boolean to execute arithmetic operation.");
+	}
+
+	// Slow path of comparisons, reports the same errors as the tree walker.
+	auto compare(const OpCode op, const RegisterValue& left, const RegisterValue& right) -> RegisterValue
+	{
+		if (left.type == RegisterType::Logic)
+		{
+			if (right.type != RegisterType::Logic) {
+				terminate_illegal_program("Logic value must be compared with other logic value.");
+			}
+
+			switch (op) {
+				case OpCode::Equal:		return make_logic(left.payload == right.payload);
+				case OpCode::NotEqual:	return make_logic(left.payload != right.payload);
+				default:				terminate_illegal_program("Logic value may not be a subject of this comparison operation.");
+			}
+		}
+
+		if (left.type == RegisterType::Number)
+		{
+			if (right.type != RegisterType::Number) {
+				terminate_illegal_program("Number value must be compared with other number value.");
+			}
+
+			switch (op) {
+				case OpCode::Equal:			return make_logic(left.payload == right.payload);
+				case OpCode::NotEqual:		return make_logic(left.payload != right.payload);
+				case OpCode::Less:			return make_logic(left.payload < right.payload);
+				case OpCode::LessOrEqual:	return make_logic(left.payload <= right.payload);
+				case OpCode::More:			return make_logic(left.payload > right.payload);
+				case OpCode::MoreOrEqual:	return make_logic(left.payload >= right.payload);
+				default:					terminate_illegal_program("Unknown comparison operation.");
+			}
+		}
+
+		terminate_illegal_program("The type can not be a subject of comparison operator.");
+	}
+}
+
+
+VirtualMachine::VirtualMachine(const BytecodeProgram& program)
+	: program(&program)
+	, jit(program)
+{
+}
+
+auto VirtualMachine::lookup(const uint16_t name, const bool is_function) -> uint32_t
+{
+	uint32_t found = ScopeEntry::none;
+
+	for (size_t i = frames.size() - 1; i > 0 && found == ScopeEntry::none; --i)
+	{
+		// Deep recursion would otherwise walk all of its frames on every lookup.
+		const LookupCache& cache = is_function ? frames[i].function_cache : frames[i].variable_cache;
+
+		if (cache.name == name) {
+			found = cache.index;
+			break;
+		}
+
+		const CallFrame& caller = frames[i - 1];
+		const auto& entries = caller.prototype->scope_entries;
+		const CallSite& site = caller.prototype->call_sites[frames[i].call_site];
+
+		for (uint32_t e = site.scope_head; e != ScopeEntry::none; e = entries[e].previous) {
+			if (entries[e].name == name && entries[e].is_function == is_function) {
+				found = is_function ? entries[e].slot : caller.base + entries[e].slot;
+				break;
+			}
+		}
+	}
+
+	if (found != ScopeEntry::none) {
+		LookupCache& cache = is_function ? frames.back().function_cache : frames.back().variable_cache;
+		cache = LookupCache{ name, found };
+	}
+
+	return found;
+}
+
+auto VirtualMachine::lookup_variable(const uint16_t name, const uint16_t message) -> uint32_t
+{
+	const uint32_t slot = lookup(name, false);
+
+	if (slot == ScopeEntry::none) {
+		fail(message);
+	}
+
+	return slot;
+}
+
+auto VirtualMachine::leave(const RegisterValue result) -> const CallFrame&
+{
+	registers[frames.back().base] = result;
+	frames.pop_back();
+	return frames.back();
+}
+
+auto VirtualMachine::find_memoized(const FunctionPrototype& callee) -> const std::optional<Value>*
+{
+	std::vector<Value>& probe = memo_table->get_probe();
+	const RegisterValue* arguments = registers.data() + frames.back().base;
+
+	for (uint16_t i = 0; i < callee.parameter_count; ++i) {
+		probe.push_back(arguments[i].to_value());
+	}
+
+	for (const uint16_t name : callee.free_reads)
+	{
+		const uint32_t slot = lookup(name, false);
+
+		if (slot == ScopeEntry::none) {
+			return nullptr;
+		}
+
+		probe.push_back(registers[slot].to_value());
+	}
+
+	if (const std::optional<Value>* memoized = memo_table->find(&callee, probe)) {
+		return memoized;
+	}
+
+	pending_memos.push_back(PendingMemo{ &callee, probe });
+	frames.back().is_memoized = true;
+	return nullptr;
+}
+
+void VirtualMachine::store_memoized(std::optional<Value> result)
+{
+	PendingMemo& pending = pending_memos.back();
+	memo_table->store(pending.function, std::move(pending.inputs), std::move(result));
+	pending_memos.pop_back();
+}
+
+void VirtualMachine::fail(const uint16_t message) const
+{
+	terminate_illegal_program(program->messages.at(message));
+}
+
+auto VirtualMachine::run(const ExecutionLimits& limits) -> std::optional<Value>
+{
+	using namespace VmOperations;
+
+	ExecutionBudget budget{ limits };
+
+	memo_table.reset();
+	pending_memos.clear();
+	is_jit_enabled = limits.jit;
+
+	if (limits.memo_capacity > 0) {
+		memo_table.emplace(limits.memo_capacity);
+	}
+
+	const FunctionPrototype* prototype = &program->prototypes.at(BytecodeProgram::main_prototype);
+
+	frames.clear();
+	frames.push_back(CallFrame{ prototype, 0 });
+	registers.assign(prototype->register_count, RegisterValue{});
+
+	const Instruction* code = prototype->code.data();
+	const Instruction* ip = code;
+	RegisterValue* r = registers.data();
+
+	for (;;)
+	{
+		const Instruction instruction = *ip++;
+
+		switch (instruction.op)
+		{
+			case OpCode::LoadConstant:
+				r[instruction.a] = prototype->constants[instruction.b];
+				break;
+
+			case OpCode::Move:
+				r[instruction.a] = r[instruction.b];
+				break;
+
+			case OpCode::Reassign:
+				if (r[instruction.a].type != r[instruction.b].type) {
+					terminate_illegal_program("Variable type can not be changed.");
+				}
+				r[instruction.a] = r[instruction.b];
+				break;
+
+			case OpCode::LoadDynamic:
+				r[instruction.a] = registers[lookup_variable(instruction.b, instruction.c)];
+				break;
+
+			case OpCode::CheckDynamic:
+				lookup_variable(instruction.b, instruction.c);
+				break;
+
+			case OpCode::StoreDynamic:
+			{
+				const uint32_t slot = lookup(instruction.b, false);
+
+				// Compiled code checks the name first, a loaded program is not trusted to.
+				if (slot == ScopeEntry::none) {
+					terminate_illegal_program("Value is null and can not be evaluated.");
+				}
+
+				RegisterValue& target = registers[slot];
+
+				if (target.type != r[instruction.a].type) {
+					terminate_illegal_program("Variable type can not be changed.");
+				}
+
+				target = r[instruction.a];
+				break;
+			}
+
+			case OpCode::Add:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_numbers(left, right)) {
+					arithmetic_failure(left);
+				}
+
+				r[instruction.a] = make_number(NumberArithmetic::add(left.payload, right.payload));
+				break;
+			}
+
+			case OpCode::Subtract:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_numbers(left, right)) {
+					arithmetic_failure(left);
+				}
+
+				r[instruction.a] = make_number(NumberArithmetic::subtract(left.payload, right.payload));
+				break;
+			}
+
+			case OpCode::Multiply:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_numbers(left, right)) {
+					arithmetic_failure(left);
+				}
+
+				r[instruction.a] = make_number(NumberArithmetic::multiply(left.payload, right.payload));
+				break;
+			}
+
+			case OpCode::Divide:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_numbers(left, right)) {
+					arithmetic_failure(left);
+				}
+
+				r[instruction.a] = make_number(left.payload / right.payload);
+				break;
+			}
+
+			case OpCode::Modulo:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_numbers(left, right)) {
+					arithmetic_failure(left);
+				}
+
+				r[instruction.a] = make_number(left.payload % right.payload);
+				break;
+			}
+
+			case OpCode::And:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_logic(left, right)) {
+					logic_failure(left);
+				}
+
+				r[instruction.a] = make_logic((left.payload != 0) && (right.payload != 0));
+				break;
+			}
+
+			case OpCode::Or:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_logic(left, right)) {
+					logic_failure(left);
+				}
+
+				r[instruction.a] = make_logic((left.payload != 0) || (right.payload != 0));
+				break;
+			}
+
+			case OpCode::Xor:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				if (!are_logic(left, right)) {
+					logic_failure(left);
+				}
+
+				r[instruction.a] = make_logic(left.payload != right.payload);
+				break;
+			}
+
+			case OpCode::Equal:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				r[instruction.a] = are_numbers(left, right)
+					? make_logic(left.payload == right.payload)
+					: compare(instruction.op, left, right);
+				break;
+			}
+
+			case OpCode::NotEqual:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				r[instruction.a] = are_numbers(left, right)
+					? make_logic(left.payload != right.payload)
+					: compare(instruction.op, left, right);
+				break;
+			}
+
+			case OpCode::Less:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				r[instruction.a] = are_numbers(left, right)
+					? make_logic(left.payload < right.payload)
+					: compare(instruction.op, left, right);
+				break;
+			}
+
+			case OpCode::LessOrEqual:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				r[instruction.a] = are_numbers(left, right)
+					? make_logic(left.payload <= right.payload)
+					: compare(instruction.op, left, right);
+				break;
+			}
+
+			case OpCode::More:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				r[instruction.a] = are_numbers(left, right)
+					? make_logic(left.payload > right.payload)
+					: compare(instruction.op, left, right);
+				break;
+			}
+
+			case OpCode::MoreOrEqual:
+			{
+				const RegisterValue& left = r[instruction.b];
+				const RegisterValue& right = r[instruction.c];
+
+				r[instruction.a] = are_numbers(left, right)
+					? make_logic(left.payload >= right.payload)
+					: compare(instruction.op, left, right);
+				break;
+			}
+
+			case OpCode::Not:
+				if (r[instruction.b].type != RegisterType::Logic) {
+					terminate_illegal_program("Negation with NOT can be done only on logic values.");
+				}
+				r[instruction.a] = make_logic(r[instruction.b].payload == 0);
+				break;
+
+			case OpCode::Negate:
+				if (r[instruction.b].type != RegisterType::Number) {
+					terminate_illegal_program("Negation with a minus can be done only on numbers!");
+				}
+				r[instruction.a] = make_number(NumberArithmetic::negate(r[instruction.b].payload));
+				break;
+
+			case OpCode::Jump:
+				ip = code + instruction.target();
+				break;
+
+			case OpCode::JumpIfFalse:
+				if (r[instruction.a].type != RegisterType::Logic) {
+					terminate_illegal_program("Expression does not evaluate to boolean.");
+				}
+				if (r[instruction.a].payload == 0) {
+					ip = code + instruction.target();
+				}
+				break;
+
+			case OpCode::Loop:
+				budget.charge();
+				ip = code + instruction.target();
+
+				if (is_jit_enabled) {
+					ip = code + jit.enter(*prototype, instruction.target(), r, budget);
+				}
+				break;
+
+			case OpCode::Call:
+			case OpCode::CallDynamic:
+			case OpCode::TailCall:
+			case OpCode::TailCallDynamic:
+			{
+				uint32_t callee_index = instruction.b;
+
+				if (instruction.op == OpCode::CallDynamic || instruction.op == OpCode::TailCallDynamic) {
+					callee_index = lookup(instruction.b, true);
+
+					if (callee_index == ScopeEntry::none) {
+						terminate_illegal_program("Function is not recognized.");
+					}
+				}
+
+				const FunctionPrototype& callee = program->prototypes[callee_index];
+
+				budget.charge();
+
+				if (prototype->call_sites[instruction.c].argument_count != callee.parameter_count) {
+					terminate_illegal_program("Function " + callee.name + " expects " + std::to_string(callee.parameter_count) + " arguments.");
+				}
+
+				const bool replaces_frame = prototype->has_private_frame
+					&& (instruction.op == OpCode::TailCall || instruction.op == OpCode::TailCallDynamic);
+
+				if (replaces_frame)
+				{
+					// The arguments move to the start of the window, the caller of the frame receives the result.
+					CallFrame& frame = frames.back();
+					std::copy_n(r + instruction.a, callee.parameter_count, r);
+
+					if (registers.size() < frame.base + callee.register_count) {
+						registers.resize(frame.base + callee.register_count);
+					}
+
+					frame.prototype = &callee;
+					frame.is_tail_call = true;
+
+					prototype = &callee;
+					code = prototype->code.data();
+					ip = code;
+					r = registers.data() + frame.base;
+
+					if (is_jit_enabled) {
+						ip = code + jit.enter(*prototype, 0, r, budget);
+					}
+					break;
+				}
+
+				budget.enter_call();
+				frames.back().pc = static_cast<uint32_t>(ip - code);
+
+				const uint32_t base = frames.back().base + instruction.a;
+				if (registers.size() < base + callee.register_count) {
+					registers.resize(base + callee.register_count);
+				}
+
+				frames.push_back(CallFrame{ &callee, base, 0, instruction.c });
+
+				if (callee.is_memoized && memo_table.has_value())
+				{
+					if (const std::optional<Value>* memoized = find_memoized(callee))
+					{
+						// The body is skipped, the frame is left as its return would.
+						if (!memoized->has_value() && prototype->call_sites[instruction.c].requires_result) {
+							terminate_illegal_program("Function does not return anything.");
+						}
+
+						budget.leave_call();
+						const CallFrame& caller = leave(memoized->has_value() ? RegisterValue::from_value(**memoized) : RegisterValue{});
+						r = registers.data() + caller.base;
+						break;
+					}
+				}
+
+				prototype = &callee;
+				code = prototype->code.data();
+				ip = code;
+				r = registers.data() + base;
+
+				if (is_jit_enabled) {
+					ip = code + jit.enter(*prototype, 0, r, budget);
+				}
+				break;
+			}
+
+			case OpCode::Return:
+			{
+				if (frames.size() == 1) {
+					finished_at = static_cast<uint32_t>(ip - code - 1);
+					return r[instruction.a].to_value();
+				}
+
+				if (frames.back().is_memoized) {
+					store_memoized(r[instruction.a].to_value());
+				}
+
+				budget.leave_call();
+				const CallFrame& caller = leave(r[instruction.a]);
+				prototype = caller.prototype;
+				code = prototype->code.data();
+				ip = code + caller.pc;
+				r = registers.data() + caller.base;
+				break;
+			}
+
+			case OpCode::ReturnNothing:
+			{
+				if (frames.size() == 1) {
+					finished_at = static_cast<uint32_t>(ip - code - 1);
+					return std::nullopt;
+				}
+
+				if (frames.back().is_tail_call || frames[frames.size() - 2].prototype->call_sites[frames.back().call_site].requires_result) {
+					terminate_illegal_program("Function does not return anything.");
+				}
+
+				if (frames.back().is_memoized) {
+					store_memoized(std::nullopt);
+				}
+
+				budget.leave_call();
+				const CallFrame& caller = leave(RegisterValue{});
+				prototype = caller.prototype;
+				code = prototype->code.data();
+				ip = code + caller.pc;
+				r = registers.data() + caller.base;
+				break;
+			}
+
+			case OpCode::Print:
+				std::cout << symbols().get_name(program->names[instruction.b]) << " = " << r[instruction.a].to_value().to_string() << "\n";
+				break;
+
+			case OpCode::PrintDynamic:
+			{
+				const std::string_view name = symbols().get_name(program->names[instruction.b]);
+				const uint32_t slot = lookup(instruction.b, false);
+
+				if (slot == ScopeEntry::none) {
+					std::cout << name << " does not exist\n";
+					terminate_illegal_program("Value is null and can not be evaluated.");
+				}
+
+				std::cout << name << " = " << registers[slot].to_value().to_string() << "\n";
+				break;
+			}
+
+			case OpCode::Fail:
+				fail(instruction.a);
+		}
+	}
+}
+
+auto VirtualMachine::get_memo_statistics() const -> MemoStatistics
+{
+	return memo_table.has_value() ? memo_table->get_statistics() : MemoStatistics{};
+}
+
+void VirtualMachine::print_summary() const
+{
+	for (const auto& global : program->globals) {
+		if (global.declared_at > finished_at) {
+			break;
+		}
+
+		std::cout << symbols().get_name(program->names[global.name]) << " = " << registers[global.slot].to_value().to_string() << "\n";
+	}
+}
+
+
+auto execute_program(const BytecodeProgram& program, const ExecutionLimits& limits) -> MemoStatistics
+{
+	VirtualMachine machine{ program };
+	const std::optional<Value> result = machine.run(limits);
+
+	AstRoot::print_result(result);
+	machine.print_summary();
+
+	return machine.get_memo_statistics();
+}
+
+auto AstRoot::execute_bytecode(const ExecutionLimits& limits) const -> MemoStatistics
+{
+	return execute_program(compile_to_bytecode(*this), limits);
+}
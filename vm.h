@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "bytecode.h"
+#include "jit.h"
+#include "memo.h"
+
+
+// Result of the last lookup of a name which started at the frame. It stays valid while the frame
+// exists, because the frames below do not change until then.
+struct LookupCache final
+{
+	static constexpr uint16_t empty = UINT16_MAX;
+
+	uint16_t name = empty;
+	uint32_t index = 0;
+};
+
+struct CallFrame final
+{
+	const FunctionPrototype* prototype;
+	uint32_t base;
+	uint32_t pc = 0;
+	uint16_t call_site = 0;		// Index of the call site in the caller's prototype.
+	bool is_tail_call = false;	// Replaced the frame which made the call, the result is required.
+	bool is_memoized = false;	// The result is stored under the inputs on top of the pending memos.
+	LookupCache variable_cache;
+	LookupCache function_cache;
+};
+
+
+// Inputs of a pure call in progress, kept until its result is known.
+struct PendingMemo final
+{
+	const FunctionPrototype* function;
+	std::vector<Value> inputs;
+};
+
+
+class VirtualMachine final
+{
+	const BytecodeProgram* program;
+	std::vector<RegisterValue> registers;
+	std::vector<CallFrame> frames;
+	std::optional<MemoTable> memo_table;
+	std::vector<PendingMemo> pending_memos;
+	Jit jit;
+	bool is_jit_enabled = false;
+	uint32_t finished_at = 0;
+
+
+	/// <summary>
+	///	Resolves a name not declared in the running function by walking the suspended callers.
+	///	Returns the absolute register (or prototype) index, or ScopeEntry::none.
+	/// </summary>
+	auto lookup(uint16_t name, bool is_function) -> uint32_t;
+
+	auto lookup_variable(uint16_t name, uint16_t message) -> uint32_t;
+
+	/// <summary>
+	///	Pops the innermost frame. The result lands in the first register of its window.
+	/// </summary>
+	auto leave(RegisterValue result) -> const CallFrame&;
+
+	/// <summary>
+	///	Looks up the inputs of the pure call which has just entered the innermost frame.
+	///	Returns the earlier result, or null after marking the frame to store its own.
+	/// </summary>
+	auto find_memoized(const FunctionPrototype& callee) -> const std::optional<Value>*;
+
+	void store_memoized(std::optional<Value> result);
+
+	[[noreturn]]
+	void fail(uint16_t message) const;
+
+public:
+	explicit VirtualMachine(const BytecodeProgram& program);
+
+	/// <summary>
+	///	Executes the main prototype. Returns the value of the top-level return, if any.
+	/// </summary>
+	auto run(const ExecutionLimits& limits) -> std::optional<Value>;
+
+	void print_summary() const;
+
+	[[nodiscard]]
+	auto get_memo_statistics() const -> MemoStatistics;
+};
+
+
+/// <summary>
+///	Runs a compiled program and prints its result and global variables.
+/// </summary>
+auto execute_program(const BytecodeProgram& program, const ExecutionLimits& limits) -> MemoStatistics;